@@ -7,6 +7,9 @@ let package = Package(
   platforms: [
     .macOS(.v10_14)
   ],
+  products: [
+    .library(name: "Ferrite", type: .static, targets: ["Ferrite"]),
+  ],
   dependencies: [
     .package(url: "https://github.com/apple/swift-package-manager.git", from: "0.1.0"),
     .package(url: "https://github.com/llvm-swift/FileCheck.git", from: "0.0.4"),
@@ -41,6 +44,9 @@ let package = Package(
     .target(
       name: "lite",
       dependencies: ["Symbolic", "LiteSupport", "silt", "SPMUtility"]),
+    .target(
+      name: "silt-bench",
+      dependencies: ["Symbolic", "SPMUtility"]),
     .target(
       name: "file-check",
       dependencies: ["Drill", "FileCheck", "SPMUtility"]),
@@ -61,13 +67,24 @@ let package = Package(
       dependencies: ["Moho", "Mantle", "Crust"]),
     .target(
       name: "InnerCore",
-      dependencies: ["Crust", "Seismography", "Mesosphere", "OuterCore", "LLVM"]),
+      dependencies: [
+        "Crust", "Seismography", "Mesosphere", "OuterCore", "LLVM", "Ferrite"
+    ]),
     .target(
       name: "Ferrite",
       dependencies: []),
+    .target(
+      name: "FerriteBenchmarks",
+      dependencies: ["Ferrite"]),
     .testTarget(
       name: "InnerCoreSupportTests",
-      dependencies: ["InnerCore"]),
+      dependencies: ["FileCheck", "InnerCore"]),
+    .testTarget(
+      name: "OuterCoreTests",
+      dependencies: ["Lithosphere", "Mantle", "Moho", "OuterCore"]),
+    .testTarget(
+      name: "SeismographyTests",
+      dependencies: ["Moho", "Seismography"]),
   ],
   cxxLanguageStandard: .cxx14
 )
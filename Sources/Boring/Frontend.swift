@@ -9,6 +9,7 @@ import Foundation
 import Basic
 import SPMUtility
 import Mantle
+import OuterCore
 import Drill
 
 public final class FrontendToolOptions: SiltToolOptions {
@@ -18,6 +19,32 @@ public final class FrontendToolOptions: SiltToolOptions {
   public var inputURLs: [Foundation.URL] = []
   public var target: String?
   public var typeCheckerDebugOptions: TypeCheckerDebugOptions = []
+  public var runtimeBitcodeURL: Foundation.URL?
+  public var runtimeLibraryURL: Foundation.URL?
+  public var outputURL: Foundation.URL?
+  public var optimizationLevel: OptimizationLevel = .none
+  public var lazyJIT: Bool = true
+  public var emitJITDump: Bool = false
+  public var profileGenerateURL: Foundation.URL?
+  public var profileUseURL: Foundation.URL?
+  public var profileAllocations: Bool = false
+  public var profileRefCounts: Bool = false
+  public var codeGenThreads: Int?
+  public var codeGenPartitionSize: Int?
+  public var optimizerThreads: Int?
+}
+
+extension OptimizationLevel: StringEnumArgument {
+  public static var completion: ShellCompletion {
+    return ShellCompletion.values([
+      (OptimizationLevel.none.rawValue, "Perform no optimizations"),
+      (OptimizationLevel.less.rawValue, "Perform quick, local optimizations"),
+      (OptimizationLevel.default.rawValue,
+       "Perform the standard set of optimizations"),
+      (OptimizationLevel.aggressive.rawValue,
+       "Perform optimizations that trade compile time for faster code"),
+    ])
+  }
 }
 
 extension Mode.VerifyLayer: StringEnumArgument {
@@ -72,13 +99,58 @@ public class SiltFrontendTool: SiltTool<FrontendToolOptions> {
   }
 
   private func translateOptions() -> Options {
+    // When generating code, look for the runtime next to the compiler if it
+    // wasn't given explicitly.
+    var runtimeBitcodeURL = self.options.runtimeBitcodeURL
+    var runtimeLibraryURL = self.options.runtimeLibraryURL
+    switch self.options.mode {
+    case .compile:
+      runtimeBitcodeURL = runtimeBitcodeURL
+        ?? SiltFrontendTool.findAdjacentFile("silt-runtime.bc")
+      runtimeLibraryURL = runtimeLibraryURL
+        ?? SiltFrontendTool.findAdjacentFile("libFerrite.a")
+    case .run:
+      // The JIT binds to the runtime linked into the compiler itself.
+      runtimeBitcodeURL = runtimeBitcodeURL
+        ?? SiltFrontendTool.findAdjacentFile("silt-runtime.bc")
+    case .dump(_), .verify(_):
+      break
+    }
+
     return Options(
       mode: self.options.mode,
       colorsEnabled: self.options.colorsEnabled,
       shouldPrintTiming: self.options.shouldPrintTiming,
       inputURLs: self.options.inputURLs,
       target: self.options.target,
-      typeCheckerDebugOptions: self.options.typeCheckerDebugOptions)
+      typeCheckerDebugOptions: self.options.typeCheckerDebugOptions,
+      runtimeBitcodeURL: runtimeBitcodeURL,
+      runtimeLibraryURL: runtimeLibraryURL,
+      outputURL: self.options.outputURL,
+      optimizationLevel: self.options.optimizationLevel,
+      lazyJIT: self.options.lazyJIT,
+      emitJITDump: self.options.emitJITDump,
+      profileGenerateURL: self.options.profileGenerateURL,
+      profileUseURL: self.options.profileUseURL,
+      profileAllocations: self.options.profileAllocations,
+      profileRefCounts: self.options.profileRefCounts,
+      codeGenThreads: self.options.codeGenThreads,
+      codeGenPartitionSize: self.options.codeGenPartitionSize,
+      optimizerThreads: self.options.optimizerThreads)
+  }
+
+  /// Finds the named file in the directory containing the `silt` executable.
+  private static func findAdjacentFile(_ name: String) -> Foundation.URL? {
+    guard let executable = Bundle.main.executableURL else {
+      return nil
+    }
+    let url = executable.resolvingSymlinksInPath()
+                        .deletingLastPathComponent()
+                        .appendingPathComponent(name)
+    guard FileManager.default.fileExists(atPath: url.path) else {
+      return nil
+    }
+    return url
   }
 
   override class func defineArguments(
@@ -128,6 +200,133 @@ public class SiltFrontendTool: SiltTool<FrontendToolOptions> {
       option: parser.add(option: "--target", kind: String.self),
       to: { opt, r in opt.target = r }
     )
+    binder.bind(
+      option: parser.add(
+        option: "--runtime-bitcode",
+        kind: String.self,
+        usage: """
+               Link the Ferrite runtime bitcode at this path into the \
+               generated module so its fast paths can be inlined
+               """,
+        completion: .filename),
+      to: { opt, r in opt.runtimeBitcodeURL = URL(fileURLWithPath: r) }
+    )
+    binder.bind(
+      option: parser.add(
+        option: "--runtime-library",
+        kind: String.self,
+        usage: "The static Ferrite runtime library to link executables with",
+        completion: .filename),
+      to: { opt, r in opt.runtimeLibraryURL = URL(fileURLWithPath: r) }
+    )
+    binder.bind(
+      option: parser.add(
+        option: "--output",
+        shortName: "-o",
+        kind: String.self,
+        usage: "Write the compiled executable to this path",
+        completion: .filename),
+      to: { opt, r in opt.outputURL = URL(fileURLWithPath: r) }
+    )
+    binder.bind(
+      option: parser.add(
+        option: "--optimize",
+        shortName: "-O",
+        kind: OptimizationLevel.self,
+        usage: "The optimization level (0-3) to compile with"),
+      to: { opt, r in opt.optimizationLevel = r }
+    )
+    binder.bind(
+      option: parser.add(
+        option: "--run",
+        kind: Bool.self,
+        usage: "Compile the input in-process with the JIT and run it"),
+      to: { opt, r in
+        if r {
+          opt.mode = .run
+        }
+    })
+    binder.bind(
+      option: parser.add(
+        option: "--no-lazy-jit",
+        kind: Bool.self,
+        usage: "With --run, compile the whole module before running it"),
+      to: { opt, r in opt.lazyJIT = !r })
+    binder.bind(
+      option: parser.add(
+        option: "--jitdump",
+        kind: Bool.self,
+        usage: """
+               With --run, write a jitdump file so `perf inject --jit` can \
+               symbolize JIT-compiled code
+               """),
+      to: { opt, r in opt.emitJITDump = r })
+    binder.bind(
+      option: parser.add(
+        option: "--profile-generate",
+        kind: String.self,
+        usage: """
+               Instrument the program to write execution counts to this \
+               path when it exits
+               """,
+        completion: .filename),
+      to: { opt, r in opt.profileGenerateURL = URL(fileURLWithPath: r) }
+    )
+    binder.bind(
+      option: parser.add(
+        option: "--profile-use",
+        kind: String.self,
+        usage: """
+               Optimize using the execution counts in a profile written by \
+               an instrumented build
+               """,
+        completion: .filename),
+      to: { opt, r in opt.profileUseURL = URL(fileURLWithPath: r) }
+    )
+    binder.bind(
+      option: parser.add(
+        option: "--profile-allocations",
+        kind: Bool.self,
+        usage: """
+               Instrument the program to report which functions allocate \
+               the most memory when it exits
+               """),
+      to: { opt, r in opt.profileAllocations = r })
+    binder.bind(
+      option: parser.add(
+        option: "--profile-refcounts",
+        kind: Bool.self,
+        usage: """
+               Instrument the program to report its busiest retain and \
+               release sites when it exits
+               """),
+      to: { opt, r in opt.profileRefCounts = r })
+    binder.bind(
+      option: parser.add(
+        option: "--codegen-threads",
+        kind: Int.self,
+        usage: """
+               The most threads to generate native code on (defaults to \
+               the number of processors)
+               """),
+      to: { opt, r in opt.codeGenThreads = r })
+    binder.bind(
+      option: parser.add(
+        option: "--codegen-partition-size",
+        kind: Int.self,
+        usage: """
+               The least code, in LLVM instructions, to generate on a \
+               thread of its own (defaults to 5000)
+               """),
+      to: { opt, r in opt.codeGenPartitionSize = r })
+    binder.bind(
+      option: parser.add(
+        option: "--optimizer-threads",
+        kind: Int.self,
+        usage: """
+               The most threads to optimize GraphIR on (defaults to 1)
+               """),
+      to: { opt, r in opt.optimizerThreads = r })
     binder.bindArray(
       positional: parser.add(
         positional: "",
@@ -14,6 +14,7 @@ import OuterCore
 
 public final class OptimizeToolOptions: SiltToolOptions {
   public var passes: [String] = []
+  public var optimizationLevel: OptimizationLevel?
   public var inputURLs: [Foundation.URL] = []
 }
 
@@ -23,39 +24,79 @@ public class SiltOptimizeTool: SiltTool<OptimizeToolOptions> {
     self.init(
       toolName: "optimize",
       usage: "[options]",
-      overview: "Run optimization pipelines on Silt source code",
+      overview: "Run optimization pipelines on Silt source code or LLVM IR",
       args: args
     )
   }
 
-  private func translateOptions() -> Options {
+  private func translateOptions(
+    inputURLs: [Foundation.URL], level: OptimizationLevel
+  ) -> Options {
     return Options(mode: .dump(.girGen),
                    colorsEnabled: false,
                    shouldPrintTiming: false,
-                   inputURLs: self.options.inputURLs,
+                   inputURLs: inputURLs,
                    target: nil,
-                   typeCheckerDebugOptions: [])
+                   typeCheckerDebugOptions: [],
+                   optimizationLevel: level)
   }
 
   override func runImpl() throws {
-    let invocation = Invocation(options: translateOptions())
+    // Textual LLVM IR is run through the LLVM pipeline for the requested
+    // level instead, and printed afterwards.
+    let irURLs = self.options.inputURLs.filter { $0.pathExtension == "ll" }
+    let siltURLs = self.options.inputURLs.filter { $0.pathExtension != "ll" }
+    if !irURLs.isEmpty {
+      let level = self.options.optimizationLevel ?? .none
+      let invocation = Invocation(options: translateOptions(inputURLs: irURLs,
+                                                            level: level))
+      if invocation.runToOptimizedIR() {
+        self.executionStatus = .failure
+        return
+      }
+      guard !siltURLs.isEmpty else {
+        self.executionStatus = .success
+        return
+      }
+    }
+
+    var passes = [OptimizerPass.Type]()
+    for name in self.options.passes {
+      guard let pass = PassPipeliner.pass(named: name) else {
+        let known = PassPipeliner.registeredPasses.map {
+          String(describing: $0)
+        }
+        print("""
+              Could not find pass named '\(name)'; \
+              known passes are \(known.joined(separator: ", "))
+              """)
+        self.executionStatus = .failure
+        return
+      }
+      passes.append(pass)
+    }
+
+    // Run the standard pipeline for the requested level, then the requested
+    // passes, and print the optimized GraphIR.  Like the rest of the driver,
+    // the level defaults to -O0.  Without -O or --pass there is nothing to
+    // run, and nothing is printed.
+    let level = self.options.optimizationLevel ?? .none
+    let shouldPrint = self.options.optimizationLevel != nil || !passes.isEmpty
+
+    let invocation = Invocation(options: translateOptions(inputURLs: siltURLs,
+                                                          level: level))
     let hadErrors = invocation.runToGIRGen { mod in
       let pipeliner = PassPipeliner(module: mod)
+      pipeliner.addStandardStages(for: level)
       pipeliner.addStage("User-Selected Passes") { p in
-        for name in self.options.passes {
-          guard let cls = NSClassFromString("OuterCore.\(name)") else {
-            print("Could not find pass named '\(name)'")
-            continue
-          }
-
-          guard let pass = cls as? OptimizerPass.Type else {
-            print("Could not find pass named '\(name)'")
-            continue
-          }
+        for pass in passes {
           p.add(pass)
         }
       }
       pipeliner.execute()
+      if shouldPrint {
+        mod.dump()
+      }
     }
     if hadErrors {
       self.executionStatus = .failure
@@ -73,6 +114,16 @@ public class SiltOptimizeTool: SiltTool<OptimizeToolOptions> {
       to: { opt, passes in
         return opt.passes.append(contentsOf: passes)
     })
+    binder.bind(
+      option: parser.add(
+        option: "--optimize",
+        shortName: "-O",
+        kind: OptimizationLevel.self,
+        usage: """
+               Run the standard pipeline for this level (0-3) before any \
+               passes given with --pass (defaults to 0)
+               """),
+      to: { opt, r in opt.optimizationLevel = r })
     binder.bindArray(
       positional: parser.add(
         positional: "",
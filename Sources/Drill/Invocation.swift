@@ -15,10 +15,16 @@ import Mantle
 import Seismography
 import OuterCore
 import InnerCore
+import LLVM
 
 extension Diagnostic.Message {
   static let noInputFiles = Diagnostic.Message(.error,
                                                "no input files provided")
+
+  static func couldNotCreateTargetMachine(
+    _ error: Error) -> Diagnostic.Message {
+    return .init(.error, "could not create target machine: \(error)")
+  }
 }
 
 extension Passes {
@@ -33,6 +39,13 @@ extension Passes {
   static let girGenModule = typeCheckFile |> Passes.girGen
   static let girOptimize = girGenModule |> Passes.optimize
   static let irGenModule = girOptimize |> Passes.irGen
+  static let linkRuntimeModule = irGenModule |> Passes.linkRuntime
+  static let compileFile =
+    linkRuntimeModule |> Passes.optimizeLLVM |> Passes.emitObjects
+                      |> Passes.linkExecutable
+  static let runFile =
+    linkRuntimeModule |> Passes.optimizeLLVM |> Passes.executeJIT
+  static let optimizeIRFile = Passes.readIR |> Passes.optimizeLLVM
 }
 
 public struct Invocation {
@@ -85,6 +98,7 @@ public struct Invocation {
     defer {
       if options.shouldPrintTiming {
         context.timer.dump(to: &stdoutStreamHandle)
+        context.dumpIRGenStatistics(to: &stdoutStreamHandle)
       }
     }
 
@@ -100,7 +114,31 @@ public struct Invocation {
 
       switch options.mode {
       case .compile:
-        fatalError("only Parse is implemented")
+        do {
+          context.targetMachine = try IRGen.makeTargetMachine(
+            triple: options.target,
+            optimizationLevel: options.optimizationLevel,
+            relocationModel: options.relocationModel)
+        } catch {
+          context.engine.diagnose(.couldNotCreateTargetMachine(error))
+          return true
+        }
+        run(Passes.compileFile)
+      case .run:
+        do {
+          context.targetMachine = try IRGen.makeTargetMachine(
+            triple: nil, optimizationLevel: options.optimizationLevel,
+            relocationModel: options.relocationModel)
+        } catch {
+          context.engine.diagnose(.couldNotCreateTargetMachine(error))
+          return true
+        }
+        guard let status = run(Passes.runFile) else {
+          return true
+        }
+        if status != 0 {
+          return true
+        }
       case .dump(.tokens):
         run(Passes.lexFile |> Pass(name: "Describe Tokens") { tokens, _ in
           TokenDescriber.describe(tokens, to: &stdoutStreamHandle,
@@ -142,8 +180,8 @@ public struct Invocation {
           module.dump()
         })
       case .dump(.irGen):
-        run(Passes.irGenModule |> Pass(name: "Dump LLVM IR") { module, _ in
-          module.dump()
+        run(Passes.linkRuntimeModule |> Pass(name: "Dump LLVM IR") { mod, _ in
+          mod.dump()
         })
       case .verify(let verification):
         switch verification {
@@ -184,6 +222,7 @@ extension Invocation {
     defer {
       if options.shouldPrintTiming {
         context.timer.dump(to: &stdoutStreamHandle)
+        context.dumpIRGenStatistics(to: &stdoutStreamHandle)
       }
     }
 
@@ -200,3 +239,43 @@ extension Invocation {
     return context.engine.hasErrors()
   }
 }
+
+extension Invocation {
+  /// Reads each input as textual LLVM IR, runs the LLVM optimization
+  /// pipeline for the requested level over it, and prints the result.
+  public func runToOptimizedIR() -> HadErrors {
+    let context = PassContext(options: options)
+    Rainbow.enabled = options.colorsEnabled
+
+    // Force Rainbow to use ANSI colors even when not in a TTY.
+    if Rainbow.outputTarget == .unknown {
+      Rainbow.outputTarget = .console
+    }
+
+    if options.inputURLs.isEmpty {
+      context.engine.diagnose(.noInputFiles)
+      return true
+    }
+
+    do {
+      context.targetMachine = try IRGen.makeTargetMachine(
+        triple: options.target, optimizationLevel: options.optimizationLevel,
+        relocationModel: options.relocationModel)
+    } catch {
+      context.engine.diagnose(.couldNotCreateTargetMachine(error))
+      return true
+    }
+
+    for url in options.inputURLs {
+      let consumer =
+        DelayedPrintingDiagnosticConsumer(stream: &stderrStreamHandle)
+      context.engine.register(consumer)
+
+      let dump = Pass<LLVM.Module, Void>(name: "Dump LLVM IR") { mod, _ in
+        mod.dump()
+      }
+      _ = (Passes.optimizeIRFile |> dump).run(url, in: context)
+    }
+    return context.engine.hasErrors()
+  }
+}
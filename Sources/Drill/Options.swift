@@ -6,7 +6,9 @@
 /// available in the repository.
 
 import Foundation
+import LLVM
 import Mantle
+import OuterCore
 
 /// The mode the compiler will be executing in.
 public enum Mode {
@@ -64,6 +66,9 @@ public enum Mode {
   case dump(DumpLayer)
   case verify(VerifyLayer)
   case compile
+  /// The compiler will compile the module in-process with the JIT and run
+  /// its entry point.
+  case run
 }
 
 public class Options {
@@ -73,6 +78,44 @@ public class Options {
   public var inputURLs: [URL] = []
   public var target: String?
   public var typeCheckerDebugOptions: TypeCheckerDebugOptions = []
+  /// The Ferrite bitcode library to link into generated code before it is
+  /// optimized, if any.
+  public var runtimeBitcodeURL: URL?
+  /// The static Ferrite library executables are linked against.
+  public var runtimeLibraryURL: URL?
+  /// Where to write the compiled executable.  Defaults to the name of the
+  /// input file without its extension.
+  public var outputURL: URL?
+  public var optimizationLevel: OptimizationLevel = .none
+  /// In run mode, whether to compile each function on first call instead of
+  /// compiling the whole module up front.
+  public var lazyJIT: Bool = true
+  /// In run mode, whether to write a jitdump file for `perf`.
+  public var emitJITDump: Bool = false
+  /// If set, generated code counts how often each function is entered and
+  /// each `switch_constr` case is taken, and writes the counts to this file
+  /// when it exits.
+  public var profileGenerateURL: URL?
+  /// A profile written by an instrumented build, used to guide optimization.
+  public var profileUseURL: URL?
+  /// If set, generated code attributes each heap allocation to the function
+  /// and type that made it, and reports the sites when it exits.
+  public var profileAllocations: Bool = false
+  /// If set, generated code counts retains, releases, copies and destroys by
+  /// call site, and reports the hottest sites when it exits.
+  public var profileRefCounts: Bool = false
+  /// The most threads to generate native code on when compiling.  Defaults
+  /// to the number of active processors.
+  public var codeGenThreads: Int?
+  /// The least code, in LLVM instructions, worth generating on a thread of
+  /// its own.  Defaults to `IRGen.defaultMinimumPartitionSize`.
+  public var codeGenPartitionSize: Int?
+  /// The most threads to run GraphIR scope passes on.  Defaults to one:
+  /// threading the optimizer is opt-in until its speedup is measured.
+  public var optimizerThreads: Int?
+  /// The relocation model of generated code.  Executables are linked as
+  /// position-independent by default.
+  public var relocationModel: RelocMode = .pic
 
   // FIXME: There is duplication here between the layers.
   public init(
@@ -81,7 +124,21 @@ public class Options {
     shouldPrintTiming: Bool = false,
     inputURLs: [URL],
     target: String?,
-    typeCheckerDebugOptions: TypeCheckerDebugOptions
+    typeCheckerDebugOptions: TypeCheckerDebugOptions,
+    runtimeBitcodeURL: URL? = nil,
+    runtimeLibraryURL: URL? = nil,
+    outputURL: URL? = nil,
+    optimizationLevel: OptimizationLevel = .none,
+    lazyJIT: Bool = true,
+    emitJITDump: Bool = false,
+    profileGenerateURL: URL? = nil,
+    profileUseURL: URL? = nil,
+    profileAllocations: Bool = false,
+    profileRefCounts: Bool = false,
+    codeGenThreads: Int? = nil,
+    codeGenPartitionSize: Int? = nil,
+    optimizerThreads: Int? = nil,
+    relocationModel: RelocMode = .pic
   ) {
     self.mode = mode
     self.colorsEnabled = colorsEnabled
@@ -89,5 +146,19 @@ public class Options {
     self.inputURLs = inputURLs
     self.target = target
     self.typeCheckerDebugOptions = typeCheckerDebugOptions
+    self.runtimeBitcodeURL = runtimeBitcodeURL
+    self.runtimeLibraryURL = runtimeLibraryURL
+    self.outputURL = outputURL
+    self.optimizationLevel = optimizationLevel
+    self.lazyJIT = lazyJIT
+    self.emitJITDump = emitJITDump
+    self.profileGenerateURL = profileGenerateURL
+    self.profileUseURL = profileUseURL
+    self.profileAllocations = profileAllocations
+    self.profileRefCounts = profileRefCounts
+    self.codeGenThreads = codeGenThreads
+    self.codeGenPartitionSize = codeGenPartitionSize
+    self.optimizerThreads = optimizerThreads
+    self.relocationModel = relocationModel
   }
 }
@@ -7,6 +7,8 @@
 
 import Foundation
 import Lithosphere
+import LLVM
+import InnerCore
 
 /// A class that's passed to invocations of each pass. It contains a timer
 /// and diagnostic engine that each pass can make use of.
@@ -14,6 +16,9 @@ final class PassContext {
   /// A timer that records the running time of each individual pass.
   let timer = PassTimer()
 
+  /// The hit rates of the caches used while generating LLVM IR.
+  let irGenStatistics = IRGenStatistics()
+
   /// The diagnostic engine which passes should use to diagnose errors and
   /// warnings.
   let engine = DiagnosticEngine()
@@ -23,7 +28,33 @@ final class PassContext {
 
   var currentConverter: SourceLocationConverter?
 
+  /// The machine code is being generated for, when compiling to native code.
+  var targetMachine: TargetMachine?
+
   init(options: Options) {
     self.options = options
   }
+
+  /// Dumps a table of the hit rates of IRGen's caches to the provided
+  /// stream, if any LLVM IR was generated.
+  ///
+  /// - Parameter target: The stream to write the table to.
+  func dumpIRGenStatistics<Target: TextOutputStream>(to target: inout Target) {
+    let caches = self.irGenStatistics.caches
+    guard caches.contains(where: { $0.statistics.lookups > 0 }) else {
+      return
+    }
+    var columns = [
+      Column(title: "Cache"), Column(title: "Lookups"),
+      Column(title: "Hits"), Column(title: "Hit Rate"),
+    ]
+    for (name, statistics) in caches {
+      columns[0].rows.append(name)
+      columns[1].rows.append("\(statistics.lookups)")
+      columns[2].rows.append("\(statistics.hits)")
+      columns[3].rows.append(
+        String(format: "%.1f%%", statistics.hitRate * 100))
+    }
+    TableFormatter.write(columns: columns, to: &target)
+  }
 }
@@ -37,6 +37,40 @@ private func processImportedFile(_ modPath: URL) -> LocalNames? {
   return locals
 }
 
+extension Diagnostic.Message {
+  static func couldNotLinkRuntime(_ error: Error) -> Diagnostic.Message {
+    return .init(.error, "\(error)")
+  }
+
+  static func couldNotEmitObject(_ error: Error) -> Diagnostic.Message {
+    return .init(.error, "could not emit object file: \(error)")
+  }
+
+  static let noRuntimeLibrary =
+    Diagnostic.Message(.error,
+                       "could not find the Ferrite runtime library to link")
+
+  static func linkerFailed(_ status: Int32) -> Diagnostic.Message {
+    return .init(.error, "linker command failed with exit code \(status)")
+  }
+
+  static func couldNotRunLinker(_ error: Error) -> Diagnostic.Message {
+    return .init(.error, "could not run the linker: \(error)")
+  }
+
+  static func couldNotExecute(_ error: Error) -> Diagnostic.Message {
+    return .init(.error, "could not execute module: \(error)")
+  }
+
+  static func couldNotReadProfile(_ error: Error) -> Diagnostic.Message {
+    return .init(.error, "could not read profile: \(error)")
+  }
+
+  static func couldNotReadIR(_ error: Error) -> Diagnostic.Message {
+    return .init(.error, "\(error)")
+  }
+}
+
 enum Passes {
   /// Reads a file and returns both the String contents of the file and
   /// the URL of the file.
@@ -136,16 +170,161 @@ enum Passes {
       return girGenModule.emitTopLevelModule()
     }
 
+  /// Runs the GraphIR pipeline selected by `-O`, optimizing separate scopes
+  /// on up to `--optimizer-threads` threads.
   static let optimize =
-    Pass<GIRModule, GIRModule>(name: "Optimize GraphIR") { module, _ in
-      let pipeliner = PassPipeliner(module: module)
-      // FIXME: Schedule mandatory optimization passes here.
+    Pass<GIRModule, GIRModule>(name: "Optimize GraphIR") { module, ctx in
+      let threads = ctx.options.optimizerThreads ?? 1
+      let pipeliner = PassPipeliner(module: module, threads: threads)
+      pipeliner.addStandardStages(for: ctx.options.optimizationLevel)
       pipeliner.execute()
       return module
     }
 
   static let irGen =
-    Pass<GIRModule, LLVM.Module>(name: "Generate LLVM IR") { module, _ in
-      return IRGen.emit(module)
+    Pass<GIRModule, LLVM.Module>(name: "Generate LLVM IR") { module, ctx in
+      let profile: ProfileMode
+      if let url = ctx.options.profileGenerateURL {
+        profile = .generate(path: url.path)
+      } else if let url = ctx.options.profileUseURL {
+        do {
+          profile = .use(try ProfileData(contentsOf: url))
+        } catch {
+          ctx.engine.diagnose(.couldNotReadProfile(error))
+          return nil
+        }
+      } else {
+        profile = .none
+      }
+      var instrumentation: IRGenInstrumentation = []
+      if ctx.options.profileAllocations {
+        instrumentation.insert(.allocations)
+      }
+      if ctx.options.profileRefCounts {
+        instrumentation.insert(.refcounting)
+      }
+      return IRGen.emit(module, targetMachine: ctx.targetMachine,
+                        profile: profile,
+                        instrumentation: instrumentation,
+                        sourceLocations: ctx.currentConverter,
+                        statistics: ctx.irGenStatistics)
+    }
+
+  /// Reads a file of textual LLVM IR.
+  static let readIR =
+    Pass<URL, LLVM.Module>(name: "Read LLVM IR") { url, ctx in
+      do {
+        return try IRGen.parseIR(atPath: url.path)
+      } catch {
+        ctx.engine.diagnose(.couldNotReadIR(error))
+        return nil
+      }
+    }
+
+  /// Runs the LLVM optimization pipeline selected by `-O`.
+  static let optimizeLLVM =
+    Pass<LLVM.Module, LLVM.Module>(name: "Optimize LLVM IR") { module, ctx in
+      IRGen.optimize(module, level: ctx.options.optimizationLevel,
+                     targetMachine: ctx.targetMachine!)
+      return module
+    }
+
+  /// Emits the module as one or more object files in a temporary
+  /// directory, generating code for large modules on several threads.
+  static let emitObjects =
+    Pass<LLVM.Module, [URL]>(name: "Emit Object Files") { module, ctx in
+      let prefix = FileManager.default.temporaryDirectory
+        .appendingPathComponent("\(module.name)-\(UUID().uuidString)")
+      let threads = ctx.options.codeGenThreads
+        ?? ProcessInfo.processInfo.activeProcessorCount
+      let partitionSize = ctx.options.codeGenPartitionSize
+        ?? IRGen.defaultMinimumPartitionSize
+      do {
+        let paths = try IRGen.emitObjects(
+          module, targetMachine: ctx.targetMachine!,
+          level: ctx.options.optimizationLevel,
+          relocationModel: ctx.options.relocationModel, threads: threads,
+          minimumPartitionSize: partitionSize,
+          toFilesWithPrefix: prefix.path)
+        return paths.map(URL.init(fileURLWithPath:))
+      } catch {
+        ctx.engine.diagnose(.couldNotEmitObject(error))
+        return nil
+      }
+    }
+
+  /// Compiles the module with the JIT and runs its entry point, returning
+  /// the exit status.
+  static let executeJIT =
+    Pass<LLVM.Module, Int32>(name: "Execute") { module, ctx in
+      let jit = SiltJIT(targetMachine: ctx.targetMachine!,
+                        emitJITDump: ctx.options.emitJITDump)
+      do {
+        try jit.add(module, lazily: ctx.options.lazyJIT)
+        return try jit.runMain()
+      } catch {
+        ctx.engine.diagnose(.couldNotExecute(error))
+        return nil
+      }
+    }
+
+  /// Links object files against the Ferrite runtime to produce an
+  /// executable.  The object files are removed afterwards.
+  static let linkExecutable =
+    Pass<[URL], URL>(name: "Link Executable") { objectURLs, ctx in
+      defer {
+        for url in objectURLs {
+          try? FileManager.default.removeItem(at: url)
+        }
+      }
+
+      guard let runtimeURL = ctx.options.runtimeLibraryURL else {
+        ctx.engine.diagnose(.noRuntimeLibrary)
+        return nil
+      }
+
+      let outputURL = ctx.options.outputURL
+        ?? URL(fileURLWithPath: ctx.options.inputURLs[0]
+                                  .deletingPathExtension().lastPathComponent)
+
+      // Ferrite is C++, so let the C++ compiler driver pick the right
+      // standard library and startup files.
+      let linker = Process()
+      linker.executableURL = URL(fileURLWithPath: "/usr/bin/env")
+      linker.arguments = ["c++"] + objectURLs.map { $0.path } + [
+        runtimeURL.path, "-o", outputURL.path,
+      ]
+      #if os(Linux)
+      linker.arguments!.append("-lpthread")
+      #endif
+
+      do {
+        try linker.run()
+      } catch {
+        ctx.engine.diagnose(.couldNotRunLinker(error))
+        return nil
+      }
+      linker.waitUntilExit()
+      guard linker.terminationStatus == 0 else {
+        ctx.engine.diagnose(.linkerFailed(linker.terminationStatus))
+        return nil
+      }
+      return outputURL
+    }
+
+  /// Links the Ferrite bitcode library into the generated module, if one was
+  /// provided, so the optimizer can inline runtime fast paths.
+  static let linkRuntime =
+    Pass<LLVM.Module, LLVM.Module>(name: "Link Runtime") { module, ctx in
+      guard let url = ctx.options.runtimeBitcodeURL else {
+        return module
+      }
+      do {
+        try IRGen.linkRuntime(into: module, bitcodeAt: url.path)
+      } catch {
+        ctx.engine.diagnose(.couldNotLinkRuntime(error))
+        return nil
+      }
+      return module
     }
 }
@@ -0,0 +1,57 @@
+/// AllocationProfile.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITE_ALLOCATIONPROFILE_H
+#define SILT_FERRITE_ALLOCATIONPROFILE_H
+
+#include "silt/Ferrite/Defines.h"
+#include "silt/Ferrite/HeapObject.h"
+#include "silt/Ferrite/InstrumentationSite.h"
+#include <atomic>
+#include <cstddef>
+
+namespace silt {
+
+/// Set once the first allocation from an instrumented site is made.  Until
+/// then, deallocations skip the profiler entirely.
+extern std::atomic<bool> allocationProfileActive;
+
+/// Attributes the deallocation of \p object to the site that allocated it.
+void recordProfiledDeallocationSlow(HeapObject *object);
+
+/// Attributes the deallocation of \p object to the site that allocated it,
+/// if it came from an instrumented site.
+///
+/// This sits on the deallocation fast path, which is inlined into generated
+/// code, so the uninstrumented case is a single load.
+inline void recordProfiledDeallocation(HeapObject *object) {
+  if (!allocationProfileActive.load(std::memory_order_relaxed)) {
+    return;
+  }
+  recordProfiledDeallocationSlow(object);
+}
+
+extern "C" {
+/// Allocates a heap object like \c silt_alloc and attributes it to an
+/// allocation site.
+///
+/// IRGen calls this instead of \c silt_alloc when compiling with
+/// \c --profile-allocations.  When the process exits, the runtime reports
+/// each site's allocations, bytes, object lifetimes and the memory it still
+/// retains, ranked by retained memory.  The report goes to the file named by
+/// \c SILT_ALLOC_PROFILE, or to stderr if that is unset or "-".
+/// @param metadata The metadata describing how to destroy the object.
+/// @param size The size, in bytes, of the object including its header.
+/// @param alignMask The required alignment of the object, minus one.
+/// @param site The allocation site.
+HeapObject *silt_alloc_profiled(const HeapMetadata *metadata,
+                                size_t size, size_t alignMask,
+                                const InstrumentationSite *site);
+}
+} /* end namespace silt */
+
+#endif /* SILT_FERRITE_ALLOCATIONPROFILE_H */
@@ -16,4 +16,15 @@
 
 #define SILT_NORETURN __attribute__((noreturn))
 
+/// Requires a global to be initialized at compile time.  The runtime has no
+/// static constructors or destructors, so that programs start and exit
+/// without running any runtime code and initialization order never matters.
+#if defined(__cpp_constinit)
+#define SILT_CONSTINIT constinit
+#elif defined(__clang__)
+#define SILT_CONSTINIT [[clang::require_constant_initialization]]
+#else
+#define SILT_CONSTINIT
+#endif
+
 #endif /* SILT_FERRITE_DEFINES_H */
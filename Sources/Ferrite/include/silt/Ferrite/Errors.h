@@ -6,6 +6,7 @@
 /// available in the repository.
 
 #ifndef SILT_FERRITE_ERRORS_H
+#define SILT_FERRITE_ERRORS_H
 
 #include "silt/Ferrite/Defines.h"
 
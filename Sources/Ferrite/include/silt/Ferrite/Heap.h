@@ -9,17 +9,33 @@
 #define SILT_FERRITE_HEAP_H
 
 #include "silt/Ferrite/Defines.h"
+#include "silt/Ferrite/HeapObject.h"
 #include <cstdlib>
 
 namespace silt {
 extern "C" {
-/// Allocates the provided number of bytes on the heap. This memory is unmanaged
-/// and will never be NULL.
-/// @param bytes The size, in bytes, of the memory to allocate.
-void *silt_alloc(size_t bytes);
-/// Deallocates a pointer allocated by \c silt_alloc.
-/// @param value The pointer to deallocate.
-void *silt_dealloc(void *value);
+/// Allocates a new heap object with the given metadata and a retain count of
+/// one.  The returned pointer will never be NULL.
+/// @param metadata The metadata describing how to destroy the object.
+/// @param size The size, in bytes, of the object including its header.
+/// @param alignMask The required alignment of the object, minus one.
+HeapObject *silt_alloc(const HeapMetadata *metadata,
+                       size_t size, size_t alignMask);
+
+/// Deallocates an object allocated by \c silt_alloc.  This is called by the
+/// object's destroyer once its fields have been torn down.
+/// @param object The object to deallocate.
+/// @param size The size, in bytes, the object was allocated with.
+/// @param alignMask The alignment mask the object was allocated with.
+void silt_dealloc(HeapObject *object, size_t size, size_t alignMask);
+
+/// Deallocates an object allocated by \c silt_alloc whose fields were never
+/// initialized.
+/// @param object The object to deallocate.
+/// @param size The size, in bytes, the object was allocated with.
+/// @param alignMask The alignment mask the object was allocated with.
+void silt_dealloc_uninitialized(HeapObject *object,
+                                size_t size, size_t alignMask);
 }
 } /* end namespace silt */
 
@@ -0,0 +1,106 @@
+/// HeapObject.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITE_HEAPOBJECT_H
+#define SILT_FERRITE_HEAPOBJECT_H
+
+#include "silt/Ferrite/Defines.h"
+#include "silt/Ferrite/RelativePointer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace silt {
+
+struct HeapObject;
+
+/// The kind of a heap metadata record.  Mirrors \c MetadataKind in
+/// InnerCore's IRGenRuntime.
+enum class MetadataKind : uintptr_t {
+  HeapLocalVariable = 1,
+};
+
+/// A function that tears down the fields of a heap object and returns its
+/// storage to the allocator.
+using HeapObjectDestroyer = void (HeapObject *object);
+
+/// The address point of the metadata for a heap-allocated object.
+///
+/// Heap objects point at this record, but the destroyer and value witnesses
+/// live at negative offsets from it; see \c FullHeapMetadata.
+struct HeapMetadata {
+  MetadataKind kind;
+};
+
+/// The complete layout of a heap metadata record.  The fields before the
+/// address point are relative pointers so that metadata emitted by the
+/// compiler needs no relocations.
+struct FullHeapMetadata {
+  /// Tears down the object.  Only null for immortal objects.
+  RelativeDirectPointer<HeapObjectDestroyer> destroy;
+  RelativeDirectPointer<const void *const> valueWitnesses;
+  HeapMetadata header;
+};
+
+/// The metadata IRGen emits for the boxes it allocates, as laid out by
+/// \c RecordLayout.getPrivateMetadata.
+struct HeapLocalVariableMetadata {
+  FullHeapMetadata full;
+  /// The offset from the start of the box to its first field.
+  uint32_t offsetToFirstField;
+  /// Describes the box's fields for reflection, if anything.
+  RelativeDirectPointer<const void> captureDescriptor;
+};
+
+static_assert(offsetof(FullHeapMetadata, header) == 8,
+              "FullHeapMetadata must match RecordLayout.getPrivateMetadata");
+static_assert(offsetof(HeapLocalVariableMetadata, offsetToFirstField)
+                == 8 + sizeof(HeapMetadata),
+              "HeapLocalVariableMetadata must match "
+              "RecordLayout.getPrivateMetadata");
+
+/// Retrieves the full metadata record for the given address point.
+inline const FullHeapMetadata *asFullMetadata(const HeapMetadata *metadata) {
+  return reinterpret_cast<const FullHeapMetadata *>(
+    reinterpret_cast<const char *>(metadata)
+      - offsetof(FullHeapMetadata, header));
+}
+
+/// The header of every reference-counted object.  This layout must match
+/// the \c silt.refcounted type in the InnerCore.
+struct HeapObject {
+  const HeapMetadata *metadata;
+  std::atomic<size_t> refCount;
+};
+
+static_assert(sizeof(HeapObject) == 2 * sizeof(void *),
+              "HeapObject must match the layout of silt.refcounted");
+
+/// The reference count of statically-allocated objects that are never
+/// destroyed.  It is far enough from zero that releases never bring it down
+/// to zero.
+constexpr size_t ImmortalRefCount = SIZE_MAX / 2;
+
+extern "C" {
+
+/// Increments the strong reference count of an object.
+/// @param object The object to retain.  May be NULL.
+/// @returns The object that was passed in.
+HeapObject *silt_retain(HeapObject *object);
+
+/// Decrements the strong reference count of an object, destroying it through
+/// its metadata if this was the last reference.
+/// @param object The object to release.  May be NULL.
+void silt_release(HeapObject *object);
+
+/// Retrieves the current strong reference count of an object.
+size_t silt_retainCount(HeapObject *object);
+}
+
+} /* end namespace silt */
+
+#endif /* SILT_FERRITE_HEAPOBJECT_H */
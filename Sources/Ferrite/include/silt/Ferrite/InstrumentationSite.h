@@ -0,0 +1,34 @@
+/// InstrumentationSite.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITE_INSTRUMENTATIONSITE_H
+#define SILT_FERRITE_INSTRUMENTATIONSITE_H
+
+#include "silt/Ferrite/Defines.h"
+#include <cstdint>
+
+namespace silt {
+
+/// A point in a Silt program that the compiler instrumented.  IRGen emits one
+/// of these as constant data for each instrumented operation and passes its
+/// address to the runtime, which uses the address as the site's identity.
+/// This layout must match the \c silt.site type in the InnerCore.
+struct InstrumentationSite {
+  /// The name of the Silt function containing the site.
+  const char *function;
+  /// What the site does, such as the type of value it allocates.
+  const char *detail;
+  /// The file the function was defined in, or NULL if unknown.
+  const char *file;
+  /// The line and column of the function's definition, or zero if unknown.
+  uint32_t line;
+  uint32_t column;
+};
+
+} /* end namespace silt */
+
+#endif /* SILT_FERRITE_INSTRUMENTATIONSITE_H */
@@ -9,23 +9,26 @@
 #define SILT_FERRITE_MANAGEDOBJECT_H
 
 #include "silt/Ferrite/Defines.h"
-#include <functional>
+#include "silt/Ferrite/HeapObject.h"
 
 namespace silt {
 
 /// A function that, given an initial value and a size, provides a copy of that
 /// value which will be able to be destroyed by an accompanying destroy
 /// function.
-using SiltCopyFunction = std::function<void *(void *)>;
+using SiltCopyFunction = void *(*)(void *);
 
 /// A function that, given an initial value, will destroy that value and render
 /// existing references to it useless.
-using SiltDestroyFunction = std::function<void (void *)>;
+using SiltDestroyFunction = void (*)(void *);
 
-class TypeMetadata;
+struct TypeMetadata;
 
 /// ManagedObject is the base class for any silt type that needs custom copy/
 /// destroy behavior.
+///
+/// Its members are plain pointers so that managed objects can be
+/// constant-initialized.
 template <typename T>
 struct SILT_PACKED ManagedObject {
   SiltCopyFunction copyImpl;
@@ -33,8 +36,9 @@ struct SILT_PACKED ManagedObject {
   TypeMetadata *metadata;
   T *value;
 public:
-  ManagedObject(SiltCopyFunction copyImpl, SiltDestroyFunction destroyImpl,
-                TypeMetadata *metadata, T *value):
+  constexpr ManagedObject(SiltCopyFunction copyImpl,
+                          SiltDestroyFunction destroyImpl,
+                          TypeMetadata *metadata, T *value):
     copyImpl(copyImpl), destroyImpl(destroyImpl),
     metadata(metadata), value(value) {}
 
@@ -58,7 +62,9 @@ void *silt_copyValue(void *value);
 /// Destroys the underlying ManagedObject pointed to by `value`.
 void silt_destroyValue(void *value);
 
-OpaqueMetadata *silt_allocEmptyBox();
+/// Retrieves the singleton box used for values with no storage.  The box is
+/// immortal: retaining and releasing it has no effect on its lifetime.
+HeapObject *silt_allocEmptyBox();
 }
 
 } /* end namespace silt */
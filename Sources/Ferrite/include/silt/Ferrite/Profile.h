@@ -0,0 +1,53 @@
+/// Profile.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITE_PROFILE_H
+#define SILT_FERRITE_PROFILE_H
+
+#include "silt/Ferrite/Defines.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace silt {
+
+/// The execution counters of one instrumented function.  The layout matches
+/// the \c silt.profile_data records emitted by IRGen.
+struct ProfileRecord {
+  /// The mangled name of the function.
+  const char *name;
+  /// A hash of the function's control flow at the time it was instrumented.
+  /// Counters are only merged or used when the hash matches.
+  uint64_t hash;
+  /// The number of counters in \c counters.
+  uint64_t numCounters;
+  /// The counters themselves.  The first counts entries to the function, the
+  /// rest count the cases taken by each \c switch_constr in order.
+  uint64_t *counters;
+};
+
+extern "C" {
+/// Registers the counters of an instrumented program.  They are written
+/// out by \c silt_profile_write, or when the process exits if that has not
+/// happened yet.
+///
+/// The profile is written to the path named by the \c SILT_PROFILE_FILE
+/// environment variable if it is set, and to \p defaultPath otherwise.  If
+/// the file already holds a profile, the new counts are added to it so that
+/// several runs of a workload can be accumulated.
+/// @param records The counter records.
+/// @param count The number of records.
+/// @param defaultPath The path chosen when the program was compiled.
+void silt_profile_register(const ProfileRecord *records, size_t count,
+                           const char *defaultPath);
+
+/// Writes the registered counters to the profile file.  Only the first call
+/// after registration writes anything.
+void silt_profile_write();
+}
+} /* end namespace silt */
+
+#endif /* SILT_FERRITE_PROFILE_H */
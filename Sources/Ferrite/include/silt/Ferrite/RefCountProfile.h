@@ -0,0 +1,51 @@
+/// RefCountProfile.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITE_REFCOUNTPROFILE_H
+#define SILT_FERRITE_REFCOUNTPROFILE_H
+
+#include "silt/Ferrite/Defines.h"
+#include "silt/Ferrite/HeapObject.h"
+#include "silt/Ferrite/InstrumentationSite.h"
+#include <cstdint>
+
+namespace silt {
+
+extern "C" {
+/// Begins an invocation of an instrumented function.
+///
+/// IRGen calls this on entry to every function when compiling with
+/// \c --profile-refcounts, and passes the result to each counting entry point
+/// the function calls.  A release of an object that the same invocation
+/// retained is reported as a redundant pair.
+/// @returns An identifier for the invocation, unique to the calling thread.
+uint64_t silt_refcount_enter();
+
+/// Retains \p object like \c silt_retain and counts the retain at \p site.
+HeapObject *silt_retain_profiled(HeapObject *object,
+                                 const InstrumentationSite *site,
+                                 uint64_t invocation);
+
+/// Releases \p object like \c silt_release and counts the release at
+/// \p site.
+void silt_release_profiled(HeapObject *object,
+                           const InstrumentationSite *site,
+                           uint64_t invocation);
+
+/// Copies \p value like \c silt_copyValue and counts the copy at \p site.
+void *silt_copyValue_profiled(void *value, const InstrumentationSite *site,
+                              uint64_t invocation);
+
+/// Destroys \p value like \c silt_destroyValue and counts the destruction at
+/// \p site.
+void silt_destroyValue_profiled(void *value, const InstrumentationSite *site,
+                                uint64_t invocation);
+}
+
+} /* end namespace silt */
+
+#endif /* SILT_FERRITE_REFCOUNTPROFILE_H */
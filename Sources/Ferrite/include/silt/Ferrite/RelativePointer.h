@@ -0,0 +1,68 @@
+/// RelativePointer.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITE_RELATIVEPOINTER_H
+#define SILT_FERRITE_RELATIVEPOINTER_H
+
+#include "silt/Ferrite/Defines.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace silt {
+
+/// A pointer stored as a signed 32-bit offset from its own address, with an
+/// offset of zero meaning null.
+///
+/// Metadata emitted by the compiler refers to other constants in the same
+/// image this way.  An absolute pointer in a position-independent image
+/// needs a dynamic relocation, applied at load time, which also makes the
+/// page holding it private to the process.  Relative pointers need
+/// neither, so the metadata can stay in read-only pages that are shared
+/// between processes.
+///
+/// Because the value depends on where the pointer is stored, relative
+/// pointers can't be copied; they only make sense in place.
+template <typename T>
+class RelativeDirectPointer {
+  int32_t offset;
+
+public:
+  constexpr RelativeDirectPointer(std::nullptr_t) : offset(0) {}
+
+  RelativeDirectPointer(const RelativeDirectPointer &) = delete;
+  RelativeDirectPointer &operator=(const RelativeDirectPointer &) = delete;
+
+  /// Points this pointer at \p target, which must be within 2GB of it.
+  void set(T *target) {
+    if (target == nullptr) {
+      offset = 0;
+      return;
+    }
+    offset = static_cast<int32_t>(reinterpret_cast<intptr_t>(target)
+                                  - reinterpret_cast<intptr_t>(this));
+  }
+
+  bool isNull() const {
+    return offset == 0;
+  }
+
+  T *get() const {
+    if (offset == 0) {
+      return nullptr;
+    }
+    auto base = reinterpret_cast<intptr_t>(this);
+    return reinterpret_cast<T *>(base + static_cast<intptr_t>(offset));
+  }
+
+  operator T *() const {
+    return get();
+  }
+};
+
+} /* end namespace silt */
+
+#endif /* SILT_FERRITE_RELATIVEPOINTER_H */
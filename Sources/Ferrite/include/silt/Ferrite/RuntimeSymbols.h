@@ -0,0 +1,36 @@
+/// RuntimeSymbols.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+///
+/// This header is plain C so that the compiler can import it to find the
+/// runtime when it executes code in-process.
+
+#ifndef SILT_FERRITE_RUNTIMESYMBOLS_H
+#define SILT_FERRITE_RUNTIMESYMBOLS_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// A runtime entry point that generated code may call.
+typedef struct {
+  /// The unmangled name of the entry point.
+  const char *name;
+  /// The address of the entry point in this process.
+  const void *address;
+} SiltRuntimeSymbol;
+
+/// Retrieves the table of runtime entry points.
+/// @param count Set to the number of entries in the table.
+const SiltRuntimeSymbol *silt_getRuntimeSymbols(size_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SILT_FERRITE_RUNTIMESYMBOLS_H */
@@ -0,0 +1,54 @@
+/// SpinLock.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITE_SPINLOCK_H
+#define SILT_FERRITE_SPINLOCK_H
+
+#include "silt/Ferrite/Defines.h"
+#include <atomic>
+
+namespace silt {
+
+/// A lock for the runtime's rarely-contended global state.  Unlike a
+/// \c std::mutex it is trivially destructible, so globals holding one need
+/// no static destructor.
+class SpinLock {
+  std::atomic_flag flag = ATOMIC_FLAG_INIT;
+
+public:
+  constexpr SpinLock() = default;
+
+  void lock() {
+    while (flag.test_and_set(std::memory_order_acquire)) {
+    }
+  }
+
+  void unlock() {
+    flag.clear(std::memory_order_release);
+  }
+};
+
+/// Holds a \c SpinLock for its lifetime.
+class SpinLockGuard {
+  SpinLock &lock;
+
+public:
+  explicit SpinLockGuard(SpinLock &lock) : lock(lock) {
+    lock.lock();
+  }
+
+  ~SpinLockGuard() {
+    lock.unlock();
+  }
+
+  SpinLockGuard(const SpinLockGuard &) = delete;
+  SpinLockGuard &operator=(const SpinLockGuard &) = delete;
+};
+
+} /* end namespace silt */
+
+#endif /* SILT_FERRITE_SPINLOCK_H */
@@ -0,0 +1,67 @@
+/// Statistics.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITE_STATISTICS_H
+#define SILT_FERRITE_STATISTICS_H
+
+#include "silt/Ferrite/Defines.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace silt {
+
+/// Whether heap statistics are being collected.  This is decided lazily on
+/// the first allocation by checking the \c SILT_FERRITE_STATS environment
+/// variable.
+enum class StatisticsState : uint8_t {
+  Unknown,
+  Disabled,
+  Enabled,
+};
+
+/// Process-wide counters maintained by the heap entry points.
+struct HeapStatistics {
+  std::atomic<StatisticsState> state;
+  std::atomic<uint64_t> allocations;
+  std::atomic<uint64_t> deallocations;
+  std::atomic<uint64_t> allocatedBytes;
+};
+
+/// The counters for this process.
+extern HeapStatistics heapStatistics;
+
+/// Decides whether statistics are enabled and, if so, records an allocation
+/// of \p size bytes.  If \c SILT_FERRITE_STATS is set, the counters are
+/// written to that path as JSON when the process exits.  A value of "-"
+/// writes to stderr.
+void recordAllocationSlow(size_t size);
+
+/// Records an allocation of \p size bytes.
+///
+/// This sits on the allocation fast path, which is inlined into generated
+/// code, so the common case of statistics being disabled is a single load.
+inline void recordAllocation(size_t size) {
+  if (heapStatistics.state.load(std::memory_order_relaxed)
+        == StatisticsState::Disabled) {
+    return;
+  }
+  recordAllocationSlow(size);
+}
+
+/// Records a deallocation.
+inline void recordDeallocation() {
+  if (heapStatistics.state.load(std::memory_order_relaxed)
+        != StatisticsState::Enabled) {
+    return;
+  }
+  heapStatistics.deallocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+} /* end namespace silt */
+
+#endif /* SILT_FERRITE_STATISTICS_H */
@@ -8,13 +8,12 @@
 #ifndef SILT_FERRITE_TYPEMETADATA_H
 #define SILT_FERRITE_TYPEMETADATA_H
 
-#include "silt/Ferrite/ManagedObject.h"
-#include <cstdlib>
+#include "silt/Ferrite/Defines.h"
+#include "silt/Ferrite/RelativePointer.h"
+#include <cstddef>
+#include <cstdint>
 
 namespace silt {
-extern "C" {
-
-}
 
 enum class TypeMetadataKind : uint8_t {
   Union,
@@ -22,14 +21,65 @@ enum class TypeMetadataKind : uint8_t {
   Record,
   Function,
   TypeMetadata,
+};
+
+/// The address point of a type metadata record.  This layout must match the
+/// \c swift.type type in the InnerCore.
+struct TypeMetadata {
+  uintptr_t kind;
+};
+
+/// The complete layout of a type metadata record.  This layout must match
+/// the \c silt.full_type type in the InnerCore.
+///
+/// Type metadata is emitted by the compiler as constant data, so the value
+/// witness table is referenced with a relative pointer.
+struct FullTypeMetadata {
+  RelativeDirectPointer<const void *const> valueWitnesses;
+  TypeMetadata header;
+};
+
+/// Retrieves the full metadata record for the given address point.
+inline const FullTypeMetadata *asFullMetadata(const TypeMetadata *metadata) {
+  return reinterpret_cast<const FullTypeMetadata *>(
+    reinterpret_cast<const char *>(metadata)
+      - offsetof(FullTypeMetadata, header));
 }
 
-class SILT_PACKED TypeMetadata {
-  ManagedObject *valueWitnessTable;
-  const char *mangledName;
-  
+/// The storage of a value whose type is only known through its metadata.
+struct OpaqueValue;
+
+/// The operations and layout of a type, used to manipulate values whose
+/// layout is not known statically.  This layout must match
+/// \c ValueWitnessFunction and \c ValueWitnessValue in the InnerCore.
+///
+/// Each operation receives the metadata of the type it was found through.
+/// The source of a take is left uninitialized.
+struct ValueWitnessTable {
+  void (*destroy)(OpaqueValue *object, const TypeMetadata *self);
+  void (*initializeWithCopy)(OpaqueValue *dest, OpaqueValue *src,
+                             const TypeMetadata *self);
+  void (*assignWithCopy)(OpaqueValue *dest, OpaqueValue *src,
+                         const TypeMetadata *self);
+  void (*initializeWithTake)(OpaqueValue *dest, OpaqueValue *src,
+                             const TypeMetadata *self);
+  void (*assignWithTake)(OpaqueValue *dest, OpaqueValue *src,
+                         const TypeMetadata *self);
+  size_t size;
+  size_t alignmentMask;
+  size_t stride;
 };
 
+static_assert(offsetof(ValueWitnessTable, size) == 5 * sizeof(void *),
+              "ValueWitnessTable must match ValueWitnessValue.size");
+
+/// Retrieves the value witnesses of the type the given metadata describes.
+inline const ValueWitnessTable *getValueWitnesses(
+    const TypeMetadata *metadata) {
+  return reinterpret_cast<const ValueWitnessTable *>(
+    asFullMetadata(metadata)->valueWitnesses.get());
+}
+
 } /* end namespace silt */
 
 #endif
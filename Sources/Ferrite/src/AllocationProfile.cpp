@@ -0,0 +1,153 @@
+/// AllocationProfile.cpp
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#include "silt/Ferrite/AllocationProfile.h"
+#include "silt/Ferrite/Heap.h"
+#include "silt/Ferrite/SpinLock.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+using namespace silt;
+
+SILT_CONSTINIT std::atomic<bool> silt::allocationProfileActive(false);
+
+namespace {
+/// The counters kept for one allocation site.
+struct SiteCounters {
+  uint64_t allocations = 0;
+  uint64_t allocatedBytes = 0;
+  uint64_t deallocations = 0;
+  /// The sum of the lifetimes of the site's deallocated objects.
+  uint64_t lifetimeNanoseconds = 0;
+  uint64_t liveBytes = 0;
+  uint64_t peakLiveBytes = 0;
+};
+
+/// An object allocated by an instrumented site that hasn't been freed.
+struct LiveObject {
+  const InstrumentationSite *site;
+  size_t size;
+  uint64_t allocatedAt;
+};
+
+/// The profiler's tables.  They are allocated on first use and never freed,
+/// so the runtime needs no static constructor or destructor for them.
+struct AllocationProfile {
+  std::unordered_map<const InstrumentationSite *, SiteCounters> sites;
+  std::unordered_map<const HeapObject *, LiveObject> liveObjects;
+};
+} // end anonymous namespace
+
+SILT_CONSTINIT static SpinLock profileLock;
+SILT_CONSTINIT static AllocationProfile *profile = nullptr;
+
+static uint64_t now() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(
+    steady_clock::now().time_since_epoch()).count();
+}
+
+/// Formats a site's source location, which may be unknown.
+static void printLocation(FILE *out, const InstrumentationSite *site) {
+  if (site->file == nullptr) {
+    fprintf(out, "<unknown>");
+    return;
+  }
+  fprintf(out, "%s:%" PRIu32 ":%" PRIu32, site->file, site->line,
+          site->column);
+}
+
+/// Writes the report, ranking sites by the memory they still retain and then
+/// by their peak.
+static void writeAllocationProfile() {
+  SpinLockGuard guard(profileLock);
+  if (profile == nullptr) {
+    return;
+  }
+
+  using Entry = std::pair<const InstrumentationSite *, SiteCounters>;
+  std::vector<Entry> entries(profile->sites.begin(), profile->sites.end());
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &lhs, const Entry &rhs) {
+    if (lhs.second.liveBytes != rhs.second.liveBytes) {
+      return lhs.second.liveBytes > rhs.second.liveBytes;
+    }
+    return lhs.second.peakLiveBytes > rhs.second.peakLiveBytes;
+  });
+
+  const char *path = getenv("SILT_ALLOC_PROFILE");
+  bool toStderr = path == nullptr || strcmp(path, "-") == 0;
+  FILE *out = toStderr ? stderr : fopen(path, "w");
+  if (out == nullptr) {
+    fprintf(stderr, "silt: could not write allocation profile to '%s'\n",
+            path);
+    return;
+  }
+
+  fprintf(out, "silt allocation profile: %zu sites\n", entries.size());
+  fprintf(out, "%12s %12s %10s %14s %12s  %s\n", "retained", "peak",
+          "allocs", "bytes", "mean life", "site");
+  for (const auto &entry : entries) {
+    const InstrumentationSite *site = entry.first;
+    const SiteCounters &counters = entry.second;
+    double meanLifetime = counters.deallocations == 0
+      ? 0.0
+      : double(counters.lifetimeNanoseconds) / counters.deallocations;
+    fprintf(out, "%12" PRIu64 " %12" PRIu64 " %10" PRIu64 " %14" PRIu64
+                 " %10.0fns  %s (%s) at ",
+            counters.liveBytes, counters.peakLiveBytes,
+            counters.allocations, counters.allocatedBytes, meanLifetime,
+            site->function, site->detail);
+    printLocation(out, site);
+    fprintf(out, "\n");
+  }
+
+  if (!toStderr) {
+    fclose(out);
+  }
+}
+
+HeapObject *silt::silt_alloc_profiled(const HeapMetadata *metadata,
+                                      size_t size, size_t alignMask,
+                                      const InstrumentationSite *site) {
+  HeapObject *object = silt_alloc(metadata, size, alignMask);
+
+  SpinLockGuard guard(profileLock);
+  if (profile == nullptr) {
+    profile = new AllocationProfile();
+    atexit(&writeAllocationProfile);
+    allocationProfileActive.store(true, std::memory_order_relaxed);
+  }
+  auto &counters = profile->sites[site];
+  counters.allocations += 1;
+  counters.allocatedBytes += size;
+  counters.liveBytes += size;
+  counters.peakLiveBytes = std::max(counters.peakLiveBytes,
+                                    counters.liveBytes);
+  profile->liveObjects[object] = LiveObject{site, size, now()};
+  return object;
+}
+
+void silt::recordProfiledDeallocationSlow(HeapObject *object) {
+  SpinLockGuard guard(profileLock);
+  auto live = profile->liveObjects.find(object);
+  if (live == profile->liveObjects.end()) {
+    // Allocated by an uninstrumented site.
+    return;
+  }
+  auto &counters = profile->sites[live->second.site];
+  counters.deallocations += 1;
+  counters.lifetimeNanoseconds += now() - live->second.allocatedAt;
+  counters.liveBytes -= live->second.size;
+  profile->liveObjects.erase(live);
+}
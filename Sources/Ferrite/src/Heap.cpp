@@ -6,17 +6,47 @@
 /// available in the repository.
 
 #include "silt/Ferrite/Heap.h"
+#include "silt/Ferrite/AllocationProfile.h"
 #include "silt/Ferrite/Errors.h"
+#include "silt/Ferrite/Statistics.h"
+#include <cstddef>
 #include <cstdio>
+#include <new>
 
-void *silt_alloc(size_t bytes) {
-  auto ptr = malloc(bytes);
+using namespace silt;
+
+/// The alignment mask malloc already guarantees on this platform.
+static constexpr size_t MallocAlignMask = alignof(std::max_align_t) - 1;
+
+static void *allocBytes(size_t size, size_t alignMask) {
+  void *ptr = nullptr;
+  if (alignMask <= MallocAlignMask) {
+    ptr = malloc(size);
+  } else if (posix_memalign(&ptr, alignMask + 1, size) != 0) {
+    ptr = nullptr;
+  }
   if (ptr == nullptr) {
     silt::crash("silt_alloc failed to allocate memory");
   }
   return ptr;
 }
 
-void silt_dealloc(void *value) {
-  free(value);
+HeapObject *silt::silt_alloc(const HeapMetadata *metadata,
+                             size_t size, size_t alignMask) {
+  auto object = reinterpret_cast<HeapObject *>(allocBytes(size, alignMask));
+  recordAllocation(size);
+  object->metadata = metadata;
+  new (&object->refCount) std::atomic<size_t>(1);
+  return object;
+}
+
+void silt::silt_dealloc(HeapObject *object, size_t, size_t) {
+  recordDeallocation();
+  recordProfiledDeallocation(object);
+  free(object);
+}
+
+void silt::silt_dealloc_uninitialized(HeapObject *object,
+                                      size_t size, size_t alignMask) {
+  silt_dealloc(object, size, alignMask);
 }
@@ -0,0 +1,39 @@
+/// HeapObject.cpp
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#include "silt/Ferrite/HeapObject.h"
+#include "silt/Ferrite/Errors.h"
+
+using namespace silt;
+
+HeapObject *silt::silt_retain(HeapObject *object) {
+  if (object == nullptr) {
+    return nullptr;
+  }
+  object->refCount.fetch_add(1, std::memory_order_relaxed);
+  return object;
+}
+
+void silt::silt_release(HeapObject *object) {
+  if (object == nullptr) {
+    return;
+  }
+  if (object->refCount.fetch_sub(1, std::memory_order_release) != 1) {
+    return;
+  }
+  // Synchronize with every other release before tearing the object down.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  HeapObjectDestroyer *destroy = asFullMetadata(object->metadata)->destroy;
+  if (destroy == nullptr) {
+    crash("released an immortal object to zero");
+  }
+  destroy(object);
+}
+
+size_t silt::silt_retainCount(HeapObject *object) {
+  return object->refCount.load(std::memory_order_relaxed);
+}
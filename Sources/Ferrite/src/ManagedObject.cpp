@@ -11,21 +11,32 @@ using namespace silt;
 
 namespace { // Begin anonymous namespace.
 
-  struct _SiltEmptyBox {
-    silt::OpaqueMetadata header;
+  /// The empty box is immortal, so it has no destroyer.
+  SILT_CONSTINIT const FullHeapMetadata _EmptyBoxStorageMetadata = {
+    { nullptr },
+    { nullptr },
+    { MetadataKind::HeapLocalVariable },
   };
 
-  silt::OpaqueMetadata _emptyBoxStorageMetadata(nullptr, nullptr, nullptr, nullptr);
-
   /// The singleton empty box storage object.
-  _SiltEmptyBox _EmptyBoxStorage = {
-    _emptyBoxStorageMetadata,
+  SILT_CONSTINIT HeapObject _EmptyBoxStorage = {
+    &_EmptyBoxStorageMetadata.header,
+    { ImmortalRefCount },
   };
 
 } // End anonymous namespace.
 
-silt::OpaqueMetadata *silt::silt_allocEmptyBox() {
-  auto OpaqueMetadata = reinterpret_cast<silt::OpaqueMetadata*>(&_EmptyBoxStorage);
-//  swift_retain(OpaqueMetadata);
-  return OpaqueMetadata;
+void *silt::silt_copyValue(void *value) {
+  auto object = reinterpret_cast<silt::OpaqueMetadata *>(value);
+  return new silt::OpaqueMetadata(object->copy());
+}
+
+void silt::silt_destroyValue(void *value) {
+  auto object = reinterpret_cast<silt::OpaqueMetadata *>(value);
+  object->destroy();
+  delete object;
+}
+
+HeapObject *silt::silt_allocEmptyBox() {
+  return &_EmptyBoxStorage;
 }
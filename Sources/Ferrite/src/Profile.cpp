@@ -0,0 +1,134 @@
+/// Profile.cpp
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#include "silt/Ferrite/Profile.h"
+#include "silt/Ferrite/SpinLock.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace silt;
+
+namespace {
+/// The counters of one function as they appear in a profile file.
+struct MergedRecord {
+  uint64_t hash;
+  std::vector<uint64_t> counters;
+};
+
+/// The program registered by \c silt_profile_register.
+struct RegisteredProfile {
+  SpinLock lock;
+  const ProfileRecord *records = nullptr;
+  size_t count = 0;
+  const char *defaultPath = nullptr;
+  bool written = false;
+};
+} // end anonymous namespace
+
+SILT_CONSTINIT static RegisteredProfile registeredProfile;
+
+static const char ProfileHeader[] = "# silt profile v1";
+
+/// Reads the records of an existing profile.  Malformed files are treated as
+/// empty so that a stale profile never stops a program from exiting.
+static void readProfile(FILE *in, std::map<std::string, MergedRecord> &out) {
+  char header[sizeof(ProfileHeader)];
+  if (fgets(header, sizeof(header), in) == nullptr ||
+      std::string(header) != ProfileHeader) {
+    return;
+  }
+
+  char name[1024];
+  uint64_t hash, numCounters;
+  while (fscanf(in, "%1023s %" SCNu64 " %" SCNu64,
+                name, &hash, &numCounters) == 3) {
+    MergedRecord record{hash, std::vector<uint64_t>(numCounters)};
+    for (auto &counter : record.counters) {
+      if (fscanf(in, "%" SCNu64, &counter) != 1) {
+        out.clear();
+        return;
+      }
+    }
+    out[name] = std::move(record);
+  }
+}
+
+static void writeProfile(FILE *out,
+                         const std::map<std::string, MergedRecord> &records) {
+  fprintf(out, "%s\n", ProfileHeader);
+  for (const auto &entry : records) {
+    fprintf(out, "%s %" PRIu64 " %zu", entry.first.c_str(),
+            entry.second.hash, entry.second.counters.size());
+    for (auto counter : entry.second.counters) {
+      fprintf(out, " %" PRIu64, counter);
+    }
+    fprintf(out, "\n");
+  }
+}
+
+void silt::silt_profile_register(const ProfileRecord *records, size_t count,
+                                 const char *defaultPath) {
+  auto &profile = registeredProfile;
+  SpinLockGuard guard(profile.lock);
+  bool firstRegistration = profile.records == nullptr;
+  profile.records = records;
+  profile.count = count;
+  profile.defaultPath = defaultPath;
+  profile.written = false;
+  if (firstRegistration) {
+    atexit(&silt_profile_write);
+  }
+}
+
+void silt::silt_profile_write() {
+  auto &profile = registeredProfile;
+  SpinLockGuard guard(profile.lock);
+  if (profile.records == nullptr || profile.written) {
+    return;
+  }
+  profile.written = true;
+
+  const char *path = getenv("SILT_PROFILE_FILE");
+  if (path == nullptr) {
+    path = profile.defaultPath;
+  }
+  if (path == nullptr) {
+    return;
+  }
+
+  std::map<std::string, MergedRecord> merged;
+  if (FILE *in = fopen(path, "r")) {
+    readProfile(in, merged);
+    fclose(in);
+  }
+
+  for (size_t i = 0; i < profile.count; ++i) {
+    const ProfileRecord &record = profile.records[i];
+    auto &existing = merged[record.name];
+    if (existing.hash != record.hash ||
+        existing.counters.size() != record.numCounters) {
+      // The function changed since the profile was written; start over.
+      existing.hash = record.hash;
+      existing.counters.assign(record.numCounters, 0);
+    }
+    for (uint64_t j = 0; j < record.numCounters; ++j) {
+      existing.counters[j] += record.counters[j];
+    }
+  }
+
+  FILE *out = fopen(path, "w");
+  if (out == nullptr) {
+    fprintf(stderr, "silt: could not write profile to '%s'\n", path);
+    return;
+  }
+  writeProfile(out, merged);
+  fclose(out);
+}
@@ -0,0 +1,215 @@
+/// RefCountProfile.cpp
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#include "silt/Ferrite/RefCountProfile.h"
+#include "silt/Ferrite/ManagedObject.h"
+#include "silt/Ferrite/SpinLock.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace silt;
+
+namespace {
+using SitePair = std::pair<const InstrumentationSite *,
+                           const InstrumentationSite *>;
+
+struct SitePairHash {
+  size_t operator()(const SitePair &pair) const {
+    std::hash<const void *> hash;
+    return hash(pair.first) * 31 + hash(pair.second);
+  }
+};
+
+/// The profiler's tables.  They are allocated on first use and never freed,
+/// so the runtime needs no static constructor or destructor for them.
+struct RefCountProfile {
+  /// The number of operations performed at each site.
+  std::unordered_map<const InstrumentationSite *, uint64_t> sites;
+  /// The number of times a retain or copy at the first site was undone by a
+  /// release or destroy at the second within the same invocation.
+  std::unordered_map<SitePair, uint64_t, SitePairHash> redundantPairs;
+};
+
+/// A retain or copy that no release or destroy has undone yet.
+struct PendingRetain {
+  uint64_t invocation;
+  const void *object;
+  const InstrumentationSite *site;
+};
+
+/// The most recent pending retains of a thread.  Older retains are forgotten,
+/// so pairs further apart than this are not reported.
+constexpr size_t PendingRetainLimit = 64;
+
+struct PendingRetains {
+  PendingRetain entries[PendingRetainLimit];
+  size_t next;
+};
+} // end anonymous namespace
+
+/// How many of the hottest sites and pairs the report lists.
+constexpr size_t ReportLimit = 20;
+
+SILT_CONSTINIT static SpinLock profileLock;
+SILT_CONSTINIT static RefCountProfile *profile = nullptr;
+
+SILT_CONSTINIT static thread_local uint64_t lastInvocation = 0;
+SILT_CONSTINIT static thread_local PendingRetains pendingRetains = {};
+
+template <typename Key, typename Hash>
+static std::vector<std::pair<Key, uint64_t>>
+hottest(const std::unordered_map<Key, uint64_t, Hash> &counts) {
+  using Entry = std::pair<Key, uint64_t>;
+  std::vector<Entry> entries(counts.begin(), counts.end());
+  size_t limit = std::min(entries.size(), ReportLimit);
+  std::partial_sort(entries.begin(), entries.begin() + limit, entries.end(),
+                    [](const Entry &lhs, const Entry &rhs) {
+    return lhs.second > rhs.second;
+  });
+  entries.resize(limit);
+  return entries;
+}
+
+static void printSite(FILE *out, const InstrumentationSite *site) {
+  fprintf(out, "%s (%s) at ", site->function, site->detail);
+  if (site->file == nullptr) {
+    fprintf(out, "<unknown>");
+    return;
+  }
+  fprintf(out, "%s:%" PRIu32 ":%" PRIu32, site->file, site->line,
+          site->column);
+}
+
+/// Writes the hottest sites, then the redundant pairs that occurred most.
+static void writeRefCountProfile() {
+  SpinLockGuard guard(profileLock);
+  if (profile == nullptr) {
+    return;
+  }
+
+  const char *path = getenv("SILT_REFCOUNT_PROFILE");
+  bool toStderr = path == nullptr || strcmp(path, "-") == 0;
+  FILE *out = toStderr ? stderr : fopen(path, "w");
+  if (out == nullptr) {
+    fprintf(stderr, "silt: could not write refcount profile to '%s'\n",
+            path);
+    return;
+  }
+
+  uint64_t total = 0;
+  for (const auto &site : profile->sites) {
+    total += site.second;
+  }
+  fprintf(out, "silt refcount profile: %" PRIu64 " operations at %zu sites\n",
+          total, profile->sites.size());
+  for (const auto &entry : hottest(profile->sites)) {
+    fprintf(out, "%14" PRIu64 "  ", entry.second);
+    printSite(out, entry.first);
+    fprintf(out, "\n");
+  }
+
+  fprintf(out, "\nredundant pairs within one invocation: %zu\n",
+          profile->redundantPairs.size());
+  for (const auto &entry : hottest(profile->redundantPairs)) {
+    fprintf(out, "%14" PRIu64 "  ", entry.second);
+    printSite(out, entry.first.first);
+    fprintf(out, "\n%14s  undone by ", "");
+    printSite(out, entry.first.second);
+    fprintf(out, "\n");
+  }
+
+  if (!toStderr) {
+    fclose(out);
+  }
+}
+
+static void countOperation(const InstrumentationSite *site) {
+  SpinLockGuard guard(profileLock);
+  if (profile == nullptr) {
+    profile = new RefCountProfile();
+    atexit(&writeRefCountProfile);
+  }
+  profile->sites[site] += 1;
+}
+
+/// Remembers a retain or copy of \p object until it is undone or forgotten.
+static void recordRetain(const void *object,
+                         const InstrumentationSite *site,
+                         uint64_t invocation) {
+  countOperation(site);
+  if (object == nullptr || invocation == 0) {
+    return;
+  }
+  PendingRetains &pending = pendingRetains;
+  pending.entries[pending.next] = PendingRetain{invocation, object, site};
+  pending.next = (pending.next + 1) % PendingRetainLimit;
+}
+
+/// Counts a release or destroy of \p object, pairing it with the latest
+/// pending retain of the same object by the same invocation.
+static void recordRelease(const void *object,
+                          const InstrumentationSite *site,
+                          uint64_t invocation) {
+  countOperation(site);
+  if (object == nullptr || invocation == 0) {
+    return;
+  }
+  PendingRetains &pending = pendingRetains;
+  for (size_t i = 1; i <= PendingRetainLimit; ++i) {
+    size_t index = (pending.next + PendingRetainLimit - i) % PendingRetainLimit;
+    PendingRetain &entry = pending.entries[index];
+    if (entry.object != object || entry.invocation != invocation) {
+      continue;
+    }
+    entry.object = nullptr;
+    SpinLockGuard guard(profileLock);
+    profile->redundantPairs[SitePair(entry.site, site)] += 1;
+    return;
+  }
+}
+
+uint64_t silt::silt_refcount_enter() {
+  return ++lastInvocation;
+}
+
+HeapObject *silt::silt_retain_profiled(HeapObject *object,
+                                       const InstrumentationSite *site,
+                                       uint64_t invocation) {
+  recordRetain(object, site, invocation);
+  return silt_retain(object);
+}
+
+void silt::silt_release_profiled(HeapObject *object,
+                                 const InstrumentationSite *site,
+                                 uint64_t invocation) {
+  // Record first: the release may free the object.
+  recordRelease(object, site, invocation);
+  silt_release(object);
+}
+
+void *silt::silt_copyValue_profiled(void *value,
+                                    const InstrumentationSite *site,
+                                    uint64_t invocation) {
+  void *copy = silt_copyValue(value);
+  // The copy is what a later destroy will undo.
+  recordRetain(copy, site, invocation);
+  return copy;
+}
+
+void silt::silt_destroyValue_profiled(void *value,
+                                      const InstrumentationSite *site,
+                                      uint64_t invocation) {
+  recordRelease(value, site, invocation);
+  silt_destroyValue(value);
+}
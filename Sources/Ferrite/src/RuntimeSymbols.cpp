@@ -0,0 +1,46 @@
+/// RuntimeSymbols.cpp
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#include "silt/Ferrite/RuntimeSymbols.h"
+#include "silt/Ferrite/AllocationProfile.h"
+#include "silt/Ferrite/Heap.h"
+#include "silt/Ferrite/HeapObject.h"
+#include "silt/Ferrite/ManagedObject.h"
+#include "silt/Ferrite/Profile.h"
+#include "silt/Ferrite/RefCountProfile.h"
+
+using namespace silt;
+
+#define SILT_RUNTIME_SYMBOL(Name) \
+  { #Name, reinterpret_cast<const void *>(&Name) }
+
+static const SiltRuntimeSymbol RuntimeSymbols[] = {
+  SILT_RUNTIME_SYMBOL(silt_alloc),
+  SILT_RUNTIME_SYMBOL(silt_alloc_profiled),
+  SILT_RUNTIME_SYMBOL(silt_dealloc),
+  SILT_RUNTIME_SYMBOL(silt_dealloc_uninitialized),
+  SILT_RUNTIME_SYMBOL(silt_retain),
+  SILT_RUNTIME_SYMBOL(silt_release),
+  SILT_RUNTIME_SYMBOL(silt_retainCount),
+  SILT_RUNTIME_SYMBOL(silt_copyValue),
+  SILT_RUNTIME_SYMBOL(silt_destroyValue),
+  SILT_RUNTIME_SYMBOL(silt_refcount_enter),
+  SILT_RUNTIME_SYMBOL(silt_retain_profiled),
+  SILT_RUNTIME_SYMBOL(silt_release_profiled),
+  SILT_RUNTIME_SYMBOL(silt_copyValue_profiled),
+  SILT_RUNTIME_SYMBOL(silt_destroyValue_profiled),
+  SILT_RUNTIME_SYMBOL(silt_allocEmptyBox),
+  SILT_RUNTIME_SYMBOL(silt_profile_register),
+  SILT_RUNTIME_SYMBOL(silt_profile_write),
+};
+
+#undef SILT_RUNTIME_SYMBOL
+
+const SiltRuntimeSymbol *silt_getRuntimeSymbols(size_t *count) {
+  *count = sizeof(RuntimeSymbols) / sizeof(RuntimeSymbols[0]);
+  return RuntimeSymbols;
+}
@@ -0,0 +1,62 @@
+/// Statistics.cpp
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#include "silt/Ferrite/Statistics.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace silt;
+
+SILT_CONSTINIT HeapStatistics silt::heapStatistics = {
+  { StatisticsState::Unknown }, { 0 }, { 0 }, { 0 },
+};
+
+/// Writes the heap counters to the file named by \c SILT_FERRITE_STATS.
+static void writeStatistics() {
+  const char *path = getenv("SILT_FERRITE_STATS");
+  if (path == nullptr) {
+    return;
+  }
+  bool toStderr = strcmp(path, "-") == 0;
+  FILE *out = toStderr ? stderr : fopen(path, "w");
+  if (out == nullptr) {
+    return;
+  }
+  fprintf(out,
+          "{\"allocations\": %llu, \"deallocations\": %llu, "
+          "\"allocatedBytes\": %llu}\n",
+          (unsigned long long)heapStatistics.allocations.load(),
+          (unsigned long long)heapStatistics.deallocations.load(),
+          (unsigned long long)heapStatistics.allocatedBytes.load());
+  if (!toStderr) {
+    fclose(out);
+  }
+}
+
+void silt::recordAllocationSlow(size_t size) {
+  auto state = heapStatistics.state.load(std::memory_order_acquire);
+  if (state == StatisticsState::Unknown) {
+    bool enabled = getenv("SILT_FERRITE_STATS") != nullptr;
+    auto expected = StatisticsState::Unknown;
+    auto desired = enabled ? StatisticsState::Enabled
+                           : StatisticsState::Disabled;
+    if (heapStatistics.state.compare_exchange_strong(expected, desired)) {
+      if (enabled) {
+        atexit(&writeStatistics);
+      }
+      state = desired;
+    } else {
+      state = expected;
+    }
+  }
+  if (state != StatisticsState::Enabled) {
+    return;
+  }
+  heapStatistics.allocations.fetch_add(1, std::memory_order_relaxed);
+  heapStatistics.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
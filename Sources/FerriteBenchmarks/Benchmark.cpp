@@ -0,0 +1,106 @@
+/// Benchmark.cpp
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <ostream>
+
+using namespace silt::bench;
+
+/// Returns the value at the given percentile of a sorted sample set, using
+/// linear interpolation between the closest ranks.
+static double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.size() == 1) {
+    return sorted.front();
+  }
+  double rank = p * (sorted.size() - 1);
+  size_t lower = static_cast<size_t>(std::floor(rank));
+  size_t upper = std::min(lower + 1, sorted.size() - 1);
+  double fraction = rank - lower;
+  return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+/// Finds an iteration count for which one sample takes at least the minimum
+/// sample time.
+static uint64_t calibrate(const Benchmark &benchmark, const Options &options) {
+  uint64_t iterations = 1;
+  while (true) {
+    uint64_t elapsed = benchmark.body(iterations, benchmark.arg);
+    if (elapsed >= options.minSampleTime) {
+      return iterations;
+    }
+    if (elapsed < options.minSampleTime / 100 || elapsed == 0) {
+      iterations *= 10;
+      continue;
+    }
+    double scale = double(options.minSampleTime) / double(elapsed);
+    return std::max<uint64_t>(iterations + 1,
+                              static_cast<uint64_t>(iterations * scale * 1.1));
+  }
+}
+
+Summary silt::bench::run(const Benchmark &benchmark, const Options &options) {
+  Summary summary;
+  summary.name = benchmark.name;
+  summary.iterations = calibrate(benchmark, options);
+
+  const double ops = double(summary.iterations * benchmark.opsPerIteration);
+  for (unsigned i = 0; i < options.samples; ++i) {
+    uint64_t elapsed = benchmark.body(summary.iterations, benchmark.arg);
+    summary.samples.push_back(double(elapsed) / ops);
+  }
+
+  std::vector<double> sorted = summary.samples;
+  std::sort(sorted.begin(), sorted.end());
+  summary.min = sorted.front();
+  summary.max = sorted.back();
+  summary.median = percentile(sorted, 0.5);
+  summary.p90 = percentile(sorted, 0.9);
+  summary.p99 = percentile(sorted, 0.99);
+  summary.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0)
+               / sorted.size();
+  double variance = 0.0;
+  for (double sample : sorted) {
+    variance += (sample - summary.mean) * (sample - summary.mean);
+  }
+  summary.stddev = sorted.size() > 1
+                 ? std::sqrt(variance / (sorted.size() - 1))
+                 : 0.0;
+  return summary;
+}
+
+void silt::bench::writeJSON(std::ostream &os, const Options &options,
+                            const std::vector<Summary> &results) {
+  os << "{\n";
+  os << "  \"unit\": \"ns/op\",\n";
+  os << "  \"samples\": " << options.samples << ",\n";
+  os << "  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Summary &s = results[i];
+    os << (i == 0 ? "\n" : ",\n");
+    os << "    {\n";
+    os << "      \"name\": \"" << s.name << "\",\n";
+    os << "      \"iterations\": " << s.iterations << ",\n";
+    os << "      \"min\": " << s.min << ",\n";
+    os << "      \"max\": " << s.max << ",\n";
+    os << "      \"mean\": " << s.mean << ",\n";
+    os << "      \"median\": " << s.median << ",\n";
+    os << "      \"stddev\": " << s.stddev << ",\n";
+    os << "      \"p90\": " << s.p90 << ",\n";
+    os << "      \"p99\": " << s.p99 << ",\n";
+    os << "      \"raw\": [";
+    for (size_t j = 0; j < s.samples.size(); ++j) {
+      os << (j == 0 ? "" : ", ") << s.samples[j];
+    }
+    os << "]\n";
+    os << "    }";
+  }
+  os << "\n  ]\n";
+  os << "}\n";
+}
@@ -0,0 +1,91 @@
+/// Benchmark.h
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+#ifndef SILT_FERRITEBENCHMARKS_BENCHMARK_H
+#define SILT_FERRITEBENCHMARKS_BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace silt {
+namespace bench {
+
+/// A monotonic nanosecond timer.  Benchmarks start and stop it around the
+/// region they wish to measure so setup work is not counted.
+class Stopwatch {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point started;
+  uint64_t elapsed = 0;
+
+public:
+  void start() { started = Clock::now(); }
+  void stop() {
+    auto delta = Clock::now() - started;
+    elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(delta)
+                 .count();
+  }
+  uint64_t nanoseconds() const { return elapsed; }
+};
+
+/// A benchmark body.  Performs the measured operation \p iterations times and
+/// returns the number of nanoseconds spent in the measured region.
+using BenchmarkFn = uint64_t (*)(uint64_t iterations, uint64_t arg);
+
+/// A registered benchmark.
+struct Benchmark {
+  /// The name the benchmark is reported under, e.g. "alloc_dealloc/64".
+  std::string name;
+  /// The body of the benchmark.
+  BenchmarkFn body;
+  /// An extra parameter passed through to the body (a size class, a thread
+  /// count, a structure depth).
+  uint64_t arg;
+  /// How many logical operations each iteration performs.  Per-operation
+  /// timings are divided by this.
+  uint64_t opsPerIteration;
+};
+
+/// Statistical summary of a benchmark's samples, in nanoseconds per
+/// operation.
+struct Summary {
+  std::string name;
+  uint64_t iterations;
+  std::vector<double> samples;
+  double min, max, mean, median, stddev, p90, p99;
+};
+
+/// Options controlling how benchmarks are run.
+struct Options {
+  /// The number of timed samples to take per benchmark.
+  unsigned samples = 20;
+  /// The minimum wall time a single sample should take, in nanoseconds.
+  /// Iteration counts are calibrated against this.
+  uint64_t minSampleTime = 10 * 1000 * 1000;
+  /// Only benchmarks whose names contain this substring are run.
+  std::string filter;
+};
+
+/// Calibrates, runs, and summarizes a single benchmark.
+Summary run(const Benchmark &benchmark, const Options &options);
+
+/// Writes the summaries as a JSON document.
+void writeJSON(std::ostream &os, const Options &options,
+               const std::vector<Summary> &results);
+
+/// Forces the compiler to assume \p value is used.
+template <typename T>
+inline void doNotOptimize(T const &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // end namespace bench
+} // end namespace silt
+
+#endif /* SILT_FERRITEBENCHMARKS_BENCHMARK_H */
@@ -0,0 +1,307 @@
+/// main.cpp
+///
+/// Copyright 2017-2018, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+///
+/// Microbenchmarks for the Ferrite runtime entry points called by generated
+/// code.  Results are written as JSON; see Benchmark.h for the format.
+
+#include "Benchmark.h"
+#include "silt/Ferrite/Heap.h"
+#include "silt/Ferrite/HeapObject.h"
+#include "silt/Ferrite/ManagedObject.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace silt;
+using namespace silt::bench;
+
+namespace { // Begin anonymous namespace.
+
+//===----------------------------------------------------------------------===//
+// Fixture metadata
+//===----------------------------------------------------------------------===//
+
+/// A leaf object with no fields to tear down.
+struct LeafObject {
+  HeapObject header;
+  uint64_t payload;
+};
+
+/// A node in a singly-linked list or binary tree.  Destroying a node
+/// releases its children, so releasing the root tears down the structure.
+struct NodeObject {
+  HeapObject header;
+  NodeObject *left;
+  NodeObject *right;
+};
+
+void destroyLeaf(HeapObject *object) {
+  silt_dealloc(object, sizeof(LeafObject), alignof(LeafObject) - 1);
+}
+
+void destroyNode(HeapObject *object) {
+  auto node = reinterpret_cast<NodeObject *>(object);
+  silt_release(&node->left->header);
+  silt_release(&node->right->header);
+  silt_dealloc(object, sizeof(NodeObject), alignof(NodeObject) - 1);
+}
+
+/// Heap metadata for a fixture.  The destroyer is a relative pointer, which
+/// can't be formed in a C++ constant initializer, so it is set on
+/// construction.
+struct FixtureMetadata {
+  FullHeapMetadata full{
+    { nullptr }, { nullptr }, { MetadataKind::HeapLocalVariable },
+  };
+
+  explicit FixtureMetadata(HeapObjectDestroyer *destroy) {
+    full.destroy.set(destroy);
+  }
+
+  const HeapMetadata *header() const {
+    return &full.header;
+  }
+};
+
+/// Storage for the fixture metadata.  Size-class benchmarks never release
+/// through this, so a leaf destroyer is fine for every size.
+const FixtureMetadata LeafMetadata(&destroyLeaf);
+
+const FixtureMetadata NodeMetadata(&destroyNode);
+
+LeafObject *makeLeaf() {
+  return reinterpret_cast<LeafObject *>(
+    silt_alloc(LeafMetadata.header(), sizeof(LeafObject),
+               alignof(LeafObject) - 1));
+}
+
+NodeObject *makeNode(NodeObject *left, NodeObject *right) {
+  auto node = reinterpret_cast<NodeObject *>(
+    silt_alloc(NodeMetadata.header(), sizeof(NodeObject),
+               alignof(NodeObject) - 1));
+  node->left = left;
+  node->right = right;
+  return node;
+}
+
+NodeObject *makeList(uint64_t length) {
+  NodeObject *head = nullptr;
+  for (uint64_t i = 0; i < length; ++i) {
+    head = makeNode(head, nullptr);
+  }
+  return head;
+}
+
+NodeObject *makeTree(uint64_t depth) {
+  if (depth == 0) {
+    return nullptr;
+  }
+  return makeNode(makeTree(depth - 1), makeTree(depth - 1));
+}
+
+//===----------------------------------------------------------------------===//
+// Benchmarks
+//===----------------------------------------------------------------------===//
+
+uint64_t allocDealloc(uint64_t iterations, uint64_t size) {
+  Stopwatch watch;
+  watch.start();
+  for (uint64_t i = 0; i < iterations; ++i) {
+    auto object = silt_alloc(LeafMetadata.header(), size, 7);
+    doNotOptimize(object);
+    silt_dealloc(object, size, 7);
+  }
+  watch.stop();
+  return watch.nanoseconds();
+}
+
+uint64_t retainRelease(uint64_t iterations, uint64_t) {
+  auto leaf = makeLeaf();
+  Stopwatch watch;
+  watch.start();
+  for (uint64_t i = 0; i < iterations; ++i) {
+    silt_retain(&leaf->header);
+    silt_release(&leaf->header);
+  }
+  watch.stop();
+  silt_release(&leaf->header);
+  return watch.nanoseconds();
+}
+
+uint64_t retainReleaseContended(uint64_t iterations, uint64_t threadCount) {
+  auto leaf = makeLeaf();
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  // Spin the workers up before starting the clock so thread creation is not
+  // part of the measurement.
+  for (uint64_t t = 0; t < threadCount; ++t) {
+    threads.emplace_back([leaf, iterations, &go] {
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (uint64_t i = 0; i < iterations; ++i) {
+        silt_retain(&leaf->header);
+        silt_release(&leaf->header);
+      }
+    });
+  }
+  Stopwatch watch;
+  watch.start();
+  go.store(true, std::memory_order_release);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  watch.stop();
+  silt_release(&leaf->header);
+  return watch.nanoseconds();
+}
+
+void *copyPayload(void *value) {
+  return value;
+}
+
+void destroyPayload(void *) {}
+
+uint64_t copyDestroyValue(uint64_t iterations, uint64_t) {
+  uint64_t payload = 42;
+  OpaqueMetadata object(&copyPayload, &destroyPayload, nullptr, &payload);
+  Stopwatch watch;
+  watch.start();
+  for (uint64_t i = 0; i < iterations; ++i) {
+    void *copy = silt_copyValue(&object);
+    doNotOptimize(copy);
+    silt_destroyValue(copy);
+  }
+  watch.stop();
+  return watch.nanoseconds();
+}
+
+uint64_t allocEmptyBox(uint64_t iterations, uint64_t) {
+  Stopwatch watch;
+  watch.start();
+  for (uint64_t i = 0; i < iterations; ++i) {
+    auto box = silt_allocEmptyBox();
+    doNotOptimize(box);
+  }
+  watch.stop();
+  return watch.nanoseconds();
+}
+
+uint64_t teardownList(uint64_t iterations, uint64_t length) {
+  Stopwatch watch;
+  for (uint64_t i = 0; i < iterations; ++i) {
+    auto head = makeList(length);
+    watch.start();
+    silt_release(&head->header);
+    watch.stop();
+  }
+  return watch.nanoseconds();
+}
+
+uint64_t teardownTree(uint64_t iterations, uint64_t depth) {
+  Stopwatch watch;
+  for (uint64_t i = 0; i < iterations; ++i) {
+    auto root = makeTree(depth);
+    watch.start();
+    silt_release(&root->header);
+    watch.stop();
+  }
+  return watch.nanoseconds();
+}
+
+std::vector<Benchmark> allBenchmarks() {
+  std::vector<Benchmark> benchmarks;
+  for (uint64_t size : { 16, 32, 64, 128, 256, 512, 1024, 4096 }) {
+    benchmarks.push_back({ "alloc_dealloc/" + std::to_string(size),
+                           &allocDealloc, size, 1 });
+  }
+  benchmarks.push_back({ "retain_release/single", &retainRelease, 0, 1 });
+  unsigned hardwareThreads = std::max(2u, std::thread::hardware_concurrency());
+  for (uint64_t threads = 2; threads <= hardwareThreads; threads *= 2) {
+    benchmarks.push_back({ "retain_release/contended/"
+                             + std::to_string(threads),
+                           &retainReleaseContended, threads, threads });
+  }
+  benchmarks.push_back({ "copy_destroy_value", &copyDestroyValue, 0, 1 });
+  benchmarks.push_back({ "alloc_empty_box", &allocEmptyBox, 0, 1 });
+  for (uint64_t length : { 1000, 100000 }) {
+    benchmarks.push_back({ "teardown/list/" + std::to_string(length),
+                           &teardownList, length, length });
+  }
+  for (uint64_t depth : { 10, 16 }) {
+    benchmarks.push_back({ "teardown/tree/" + std::to_string(depth),
+                           &teardownTree, depth, (1u << depth) - 1 });
+  }
+  return benchmarks;
+}
+
+void printUsage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--filter <substring>] [--samples <n>]\n"
+          "          [--min-time-ms <ms>] [--output <file.json>] [--list]\n",
+          argv0);
+}
+
+} // End anonymous namespace.
+
+int main(int argc, char **argv) {
+  Options options;
+  const char *outputPath = nullptr;
+  bool listOnly = false;
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--filter") && hasValue) {
+      options.filter = argv[++i];
+    } else if (!strcmp(argv[i], "--samples") && hasValue) {
+      options.samples = std::max(1, atoi(argv[++i]));
+    } else if (!strcmp(argv[i], "--min-time-ms") && hasValue) {
+      options.minSampleTime = strtoull(argv[++i], nullptr, 10) * 1000 * 1000;
+    } else if (!strcmp(argv[i], "--output") && hasValue) {
+      outputPath = argv[++i];
+    } else if (!strcmp(argv[i], "--list")) {
+      listOnly = true;
+    } else {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<Summary> results;
+  for (const Benchmark &benchmark : allBenchmarks()) {
+    if (benchmark.name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    if (listOnly) {
+      std::cout << benchmark.name << "\n";
+      continue;
+    }
+    results.push_back(run(benchmark, options));
+    const Summary &s = results.back();
+    fprintf(stderr, "%-32s median %10.2f ns/op  (stddev %.2f)\n",
+            s.name.c_str(), s.median, s.stddev);
+  }
+  if (listOnly) {
+    return EXIT_SUCCESS;
+  }
+
+  if (outputPath == nullptr) {
+    writeJSON(std::cout, options, results);
+    return EXIT_SUCCESS;
+  }
+  std::ofstream output(outputPath);
+  if (!output) {
+    fprintf(stderr, "error: could not open '%s' for writing\n", outputPath);
+    return EXIT_FAILURE;
+  }
+  writeJSON(output, options, results);
+  return EXIT_SUCCESS;
+}
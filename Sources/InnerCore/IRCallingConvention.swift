@@ -5,6 +5,7 @@
 /// This project is released under the MIT license, a copy of which is
 /// available in the repository.
 
+import cllvm
 import Seismography
 import LLVM
 
@@ -12,15 +13,36 @@ import LLVM
 
 struct LoweredSignature {
   let type: LLVM.FunctionType
+  /// The LLVM parameters that pass values by address, with the type info of
+  /// the values.  An indirect result is always the first parameter.
+  let indirectParameters: [(index: Int, typeInfo: TypeInfo)]
 
   init(_ IGM: IRGenModule, _ formalType: Seismography.FunctionType) {
-    self.type = Builder(IGM, formalType).expandFunctionType()
+    let builder = Builder(IGM, formalType)
+    self.type = builder.expandFunctionType()
+    self.indirectParameters = builder.indirectParameters
+  }
+
+  /// Tells LLVM that the buffers of values passed by address belong to the
+  /// call: nothing else refers to them while it runs, and it keeps no
+  /// reference to them afterwards.
+  func addAttributes(to function: Function) {
+    for (index, typeInfo) in self.indirectParameters {
+      let attributeIndex = LLVMAttributeIndex(index + 1)
+      addEnumAttribute("noalias", to: function.asLLVM(), at: attributeIndex)
+      addEnumAttribute("nocapture", to: function.asLLVM(), at: attributeIndex)
+      if let fixedTI = typeInfo as? FixedTypeInfo, !fixedTI.isKnownEmpty {
+        addEnumAttribute("dereferenceable", to: function.asLLVM(),
+                         at: attributeIndex, fixedTI.fixedSize.rawValue)
+      }
+    }
   }
 
   private final class Builder {
     let IGM: IRGenModule
     let functionType: Seismography.FunctionType
     var parameterTypes: [IRType]
+    var indirectParameters = [(index: Int, typeInfo: TypeInfo)]()
 
     init(_ IGM: IRGenModule, _ fnType: Seismography.FunctionType) {
       self.IGM = IGM
@@ -62,6 +84,7 @@ struct LoweredSignature {
       let fTy = (self.functionType.returnType as! Seismography.FunctionType)
       let resultType = fTy.arguments[0]
       let resultTI = self.IGM.getTypeInfo(resultType)
+      self.indirectParameters.append((self.parameterTypes.count, resultTI))
       self.parameterTypes.append(PointerType(pointee: resultTI.llvmType))
       return VoidType()
     }
@@ -70,6 +93,7 @@ struct LoweredSignature {
       let ti = self.IGM.getTypeInfo(girTy)
       let nativeSchema = self.IGM.typeConverter.parameterConvention(for: girTy)
       if nativeSchema.isIndirect {
+        self.indirectParameters.append((self.parameterTypes.count, ti))
         self.parameterTypes.append(PointerType(pointee: ti.llvmType))
         return
       }
@@ -342,11 +366,44 @@ struct AggregateLowering {
   var isEmpty: Bool {
     return self.entries.isEmpty
   }
+
+  /// The number of registers the lowered value occupies, counting one for
+  /// each pointer-sized piece of every entry.
+  func registerCount(_ IGM: IRGenModule) -> Int {
+    let registerSize = IGM.getPointerSize().rawValue
+    return self.entries.reduce(0) { count, entry in
+      let size = (entry.end - entry.begin).rawValue
+      return count + max(1, Int((size + registerSize - 1) / registerSize))
+    }
+  }
 }
 
 // MARK: Calling Convention
 
+/// Decides how a value crosses a function boundary.
+///
+/// Small values travel in registers: a parameter as one LLVM argument per
+/// lowered entry, and a result as a single scalar or a first-class
+/// aggregate that LLVM returns in several registers.  Values too large for
+/// that, and values without a fixed layout, travel through a buffer the
+/// caller allocates:
+///
+/// - An indirect parameter is a pointer to a buffer holding the value.  The
+///   callee takes the value out of it in its prologue, before it binds the
+///   parameters of its entry continuation.
+/// - An indirect result is a pointer passed as the first parameter, to
+///   uninitialized memory the callee initializes before it returns.
+///
+/// Passing too many scalars would exhaust the argument registers, and
+/// LLVM quietly returns over-sized aggregates through a hidden stack slot.
+/// Either way, values would be spilled and reloaded at every call.
 struct NativeConvention {
+  /// The most registers a parameter is passed in.
+  static let maximumDirectParameterRegisters = 4
+  /// The most registers a result is returned in.  The C convention only
+  /// returns two on most targets.
+  static let maximumDirectResultRegisters = 2
+
   let lowering: AggregateLowering
   let isIndirect: Bool
   let isReturn: Bool
@@ -361,7 +418,10 @@ struct NativeConvention {
     }
     loadable.buildAggregateLowering(IGM, lowering, .zero)
     self.lowering = lowering.finalize()
-    self.isIndirect =  false //lowering.shouldPassIndirectly(isReturn)
+    let limit = isReturn
+      ? NativeConvention.maximumDirectResultRegisters
+      : NativeConvention.maximumDirectParameterRegisters
+    self.isIndirect = self.lowering.registerCount(IGM) > limit
   }
 
   var isEmpty: Bool {
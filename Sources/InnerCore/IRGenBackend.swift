@@ -0,0 +1,212 @@
+/// IRGenBackend.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import cllvm
+import LLVM
+import OuterCore
+
+extension OptimizationLevel {
+  /// The code generator's optimization level for this level.
+  var codeGenOptLevel: CodeGenOptLevel {
+    switch self {
+    case .none: return .none
+    case .less: return .less
+    case .default: return .default
+    case .aggressive: return .aggressive
+    }
+  }
+
+  /// The inlining threshold LLVM uses at this level, or `nil` if the
+  /// inliner should not run.  These match clang's defaults.
+  var inlineThreshold: UInt32? {
+    switch self {
+    case .none: return nil
+    case .less: return 225
+    case .default: return 225
+    case .aggressive: return 275
+    }
+  }
+
+  /// Whether LLVM unrolls loops at this level.  Silt programs loop by
+  /// recursion, so the few loops LLVM finds rarely repay the code growth at
+  /// `-O1`.
+  var unrollsLoops: Bool {
+    return self >= .default
+  }
+}
+
+/// An error raised while reading a module of textual LLVM IR.
+public enum IRParseError: Error, CustomStringConvertible {
+  /// The file could not be read.
+  case couldNotRead(String, String)
+  /// The file was read but did not contain a valid module.
+  case invalidIR(String, String)
+
+  public var description: String {
+    switch self {
+    case let .couldNotRead(path, message):
+      return "could not read LLVM IR at '\(path)': \(message)"
+    case let .invalidIR(path, message):
+      return "'\(path)' is not valid LLVM IR: \(message)"
+    }
+  }
+}
+
+extension IRGen {
+  /// Creates a target machine for the given triple, or for the host if no
+  /// triple is provided.
+  public static func makeTargetMachine(
+    triple: String?, optimizationLevel: OptimizationLevel,
+    relocationModel: RelocMode
+  ) throws -> TargetMachine {
+    let level = optimizationLevel.codeGenOptLevel
+    guard let triple = triple else {
+      return try TargetMachine(optLevel: level, relocMode: relocationModel)
+    }
+    return try TargetMachine(triple: triple, optLevel: level,
+                             relocMode: relocationModel)
+  }
+
+  /// Runs the LLVM optimization pipeline for the given level over a module.
+  ///
+  /// Runtime bitcode must already be linked into the module for its fast
+  /// paths to be inlined; see `IRGen.linkRuntime(into:bitcodeAt:)`.
+  ///
+  /// The reference counting optimizer runs once the function passes have
+  /// cleaned up IRGen's output, and again after inlining.  The runtime's
+  /// reference counting entry points are kept out of line until then so it
+  /// can still recognize them, and are inlined afterwards.
+  public static func optimize(
+    _ module: Module, level: OptimizationLevel, targetMachine: TargetMachine
+  ) {
+    guard level != .none else {
+      return
+    }
+    let refCounts = RefCountOptimizer(module: module)
+
+    let builder = LLVMPassManagerBuilderCreate()
+    defer { LLVMPassManagerBuilderDispose(builder) }
+    LLVMPassManagerBuilderSetOptLevel(builder, UInt32(level.level))
+    if let threshold = level.inlineThreshold {
+      LLVMPassManagerBuilderUseInlinerWithThreshold(builder, threshold)
+    }
+    LLVMPassManagerBuilderSetDisableUnrollLoops(
+      builder, level.unrollsLoops ? 0 : 1)
+
+    let functionPasses = LLVMCreateFunctionPassManagerForModule(module.llvm)
+    defer { LLVMDisposePassManager(functionPasses) }
+    LLVMAddAnalysisPasses(targetMachine.llvm, functionPasses)
+    LLVMPassManagerBuilderPopulateFunctionPassManager(builder, functionPasses)
+    LLVMInitializeFunctionPassManager(functionPasses)
+    var function = LLVMGetFirstFunction(module.llvm)
+    while let fn = function {
+      LLVMRunFunctionPassManager(functionPasses, fn)
+      function = LLVMGetNextFunction(fn)
+    }
+    LLVMFinalizeFunctionPassManager(functionPasses)
+    refCounts.run()
+
+    let withheld = self.withholdRefCountingFromInlining(in: module)
+    let modulePasses = LLVMCreatePassManager()
+    defer { LLVMDisposePassManager(modulePasses) }
+    LLVMAddAnalysisPasses(targetMachine.llvm, modulePasses)
+    LLVMPassManagerBuilderPopulateModulePassManager(builder, modulePasses)
+    LLVMRunPassManager(modulePasses, module.llvm)
+    refCounts.run()
+
+    guard !withheld.isEmpty else {
+      return
+    }
+    let noInline = LLVMGetEnumAttributeKindForName("noinline", 8)
+    for fn in withheld {
+      LLVMRemoveEnumAttributeAtIndex(fn, functionAttributeIndex, noInline)
+    }
+    let cleanupPasses = LLVMCreatePassManager()
+    defer { LLVMDisposePassManager(cleanupPasses) }
+    LLVMAddAnalysisPasses(targetMachine.llvm, cleanupPasses)
+    LLVMAddFunctionInliningPass(cleanupPasses)
+    LLVMAddInstructionCombiningPass(cleanupPasses)
+    LLVMAddCFGSimplificationPass(cleanupPasses)
+    LLVMAddEarlyCSEPass(cleanupPasses)
+    LLVMRunPassManager(cleanupPasses, module.llvm)
+  }
+
+  /// Reads a module of textual LLVM IR, so the optimization pipeline can be
+  /// tested on hand-written IR.
+  public static func parseIR(atPath path: String) throws -> Module {
+    var buffer: LLVMMemoryBufferRef?
+    var message: UnsafeMutablePointer<Int8>?
+    guard
+      LLVMCreateMemoryBufferWithContentsOfFile(path, &buffer, &message) == 0
+    else {
+      let reason = message.map { String(cString: $0) } ?? "unknown error"
+      LLVMDisposeMessage(message)
+      throw IRParseError.couldNotRead(path, reason)
+    }
+
+    // N.B. This consumes the buffer.
+    var module: LLVMModuleRef?
+    guard
+      LLVMParseIRInContext(LLVMGetGlobalContext(), buffer,
+                           &module, &message) == 0,
+      let parsed = module
+    else {
+      let reason = message.map { String(cString: $0) } ?? "unknown error"
+      LLVMDisposeMessage(message)
+      throw IRParseError.invalidIR(path, reason)
+    }
+    return Module(llvm: parsed)
+  }
+
+  /// Marks the runtime's reference counting entry points that were linked
+  /// into the module `noinline`, returning those that were not already.
+  private static func withholdRefCountingFromInlining(
+    in module: Module
+  ) -> [LLVMValueRef] {
+    let noInline = LLVMGetEnumAttributeKindForName("noinline", 8)
+    let entryPoints: [RuntimeIntrinsic] = [
+      .retain, .release, .copyValue, .destroyValue
+    ]
+    return entryPoints.compactMap { intrinsic in
+      guard
+        let fn = LLVMGetNamedFunction(module.llvm, intrinsic.rawValue),
+        LLVMCountBasicBlocks(fn) > 0,
+        LLVMGetEnumAttributeAtIndex(fn, functionAttributeIndex, noInline) == nil
+      else {
+        return nil
+      }
+      let attribute =
+        LLVMCreateEnumAttribute(module.context.llvm, noInline, 0)
+      LLVMAddAttributeAtIndex(fn, functionAttributeIndex, attribute)
+      return fn
+    }
+  }
+
+  /// Emits a module as a native object file.
+  public static func emitObject(
+    _ module: Module, targetMachine: TargetMachine, to path: String
+  ) throws {
+    try module.verify()
+    try targetMachine.emitToFile(module: module, type: .object, path: path)
+  }
+}
+
+extension IRGen {
+  /// Configures a module's target triple and data layout to match the
+  /// target machine.  This must happen before any types are laid out.
+  static func configureTarget(
+    of module: Module, for targetMachine: TargetMachine
+  ) {
+    if let triple = LLVMGetTargetMachineTriple(targetMachine.llvm) {
+      LLVMSetTarget(module.llvm, triple)
+      LLVMDisposeMessage(triple)
+    }
+    let layout = LLVMCreateTargetDataLayout(targetMachine.llvm)
+    LLVMSetModuleDataLayout(module.llvm, layout)
+    LLVMDisposeTargetData(layout)
+  }
+}
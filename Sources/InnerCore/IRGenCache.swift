@@ -0,0 +1,84 @@
+/// IRGenCache.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Seismography
+
+/// Counts the lookups made in one of IRGen's caches.
+public struct CacheStatistics {
+  /// The lookups that found an entry.
+  public fileprivate(set) var hits = 0
+  /// The lookups that had to compute an entry.
+  public fileprivate(set) var misses = 0
+
+  public var lookups: Int {
+    return self.hits + self.misses
+  }
+
+  /// The fraction of lookups that found an entry, or 0 if there were none.
+  public var hitRate: Double {
+    guard self.lookups > 0 else {
+      return 0
+    }
+    return Double(self.hits) / Double(self.lookups)
+  }
+}
+
+/// Records how well the caches of an IRGen session performed.
+public final class IRGenStatistics {
+  /// Mangled names of types, as used by type metadata symbols.
+  public internal(set) var mangledNames = CacheStatistics()
+  /// References to the metadata of types.
+  public internal(set) var typeMetadata = CacheStatistics()
+  /// Complete type info.
+  public internal(set) var typeInfo = CacheStatistics()
+
+  public init() {}
+
+  /// Every cache's statistics, labeled with the name of the cache.
+  public var caches: [(name: String, statistics: CacheStatistics)] {
+    return [
+      ("Mangled Names", self.mangledNames),
+      ("Type Metadata", self.typeMetadata),
+      ("Type Info", self.typeInfo),
+    ]
+  }
+}
+
+/// Memoizes a value computed from a type, keyed on the identity of the type.
+///
+/// `Value`'s own hash formats its object identifier as a string, which is
+/// far more expensive than the work some of IRGen's lookups save.  Entries
+/// here hold their type, so its identifier cannot be reused by another type
+/// while the cache is alive.
+final class TypeIdentityCache<Entry> {
+  private var entries = [ObjectIdentifier: (type: GIRType, entry: Entry)]()
+  private let statistics: IRGenStatistics
+  private let counter: ReferenceWritableKeyPath<IRGenStatistics,
+                                                CacheStatistics>
+
+  init(_ statistics: IRGenStatistics,
+       _ counter: ReferenceWritableKeyPath<IRGenStatistics, CacheStatistics>) {
+    self.statistics = statistics
+    self.counter = counter
+  }
+
+  /// Returns the entry for a type, computing and remembering it if there is
+  /// none.
+  ///
+  /// `compute` may look up other types in this cache.
+  func entry(for type: GIRType, _ compute: () -> Entry) -> Entry {
+    let key = ObjectIdentifier(type)
+    if let hit = self.entries[key] {
+      self.statistics[keyPath: self.counter].hits += 1
+      return hit.entry
+    }
+    self.statistics[keyPath: self.counter].misses += 1
+    let entry = compute()
+    self.entries[key] = (type, entry)
+    return entry
+  }
+}
@@ -0,0 +1,75 @@
+/// IRGenEffects.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import cllvm
+import LLVM
+import Seismography
+import OuterCore
+
+extension IRGenGIRFunction {
+  /// Describes the effects of this function to LLVM, so calls to it may be
+  /// reused, hoisted out of loops, or removed when their results are unused.
+  func addEffectAttributes() {
+    let function = self.function.asLLVM()
+    // Silt code never unwinds.
+    addEnumAttribute("nounwind", to: function)
+
+    // Profiling counters and instrumentation are effects of their own that
+    // must not be optimized away with the call.
+    if case .generate(_) = IGM.profileMode {
+      return
+    }
+    guard IGM.instrumentation.isEmpty else {
+      return
+    }
+
+    var effects = EffectSummary(self.schedule) { type in
+      let typeInfo = self.getTypeInfo(type)
+      guard typeInfo is LoadableTypeInfo else {
+        return .opaque
+      }
+      return typeInfo.isPOD ? .trivial : .referenceCounted
+    }
+    effects.argumentMemory.formUnion(self.loweredArgumentAccess())
+
+    if !effects.mayNotReturn {
+      addEnumAttribute("willreturn", to: function)
+    }
+
+    let access = effects.argumentMemory.union(effects.otherMemory)
+    guard !access.isEmpty else {
+      addEnumAttribute("readnone", to: function)
+      return
+    }
+    if !access.contains(.write) {
+      addEnumAttribute("readonly", to: function)
+    } else if !access.contains(.read) {
+      addEnumAttribute("writeonly", to: function)
+    }
+    if effects.otherMemory.isEmpty {
+      addEnumAttribute("argmemonly", to: function)
+    }
+  }
+
+  /// Returns the accesses to argument memory the calling convention adds:
+  /// parameters passed indirectly are read, and an indirect result is
+  /// written.
+  private func loweredArgumentAccess() -> EffectSummary.Access {
+    var access: EffectSummary.Access = []
+    if self.indirectReturn != nil {
+      access.insert(.write)
+    }
+    for param in self.scope.entry.parameters.dropLast()
+        where param.type.category == .object {
+      let schema = IGM.typeConverter.parameterConvention(for: param.type)
+      if schema.isIndirect {
+        access.insert(.read)
+      }
+    }
+    return access
+  }
+}
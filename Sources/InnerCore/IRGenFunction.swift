@@ -70,6 +70,11 @@ class IRGenFunction {
   let functionType: LLVM.FunctionType
   lazy var GR: IRGenRuntime = IRGenRuntime(irGenFunction: self)
   let B: IRBuilder
+  /// The invocation identifier passed to counting reference counting entry
+  /// points, if this function begins one.
+  var refcountInvocation: IRValue?
+  /// The number of instrumented reference counting calls emitted so far.
+  var refcountSiteCount = 0
 
   init(_ IGM: IRGenModule, _ function: Function, _ fty: LLVM.FunctionType) {
     self.IGM = IGM
@@ -92,6 +97,8 @@ final class IRGenGIRFunction: IRGenFunction {
   var blockMap = [Continuation: LoweredBB]()
   var loweredValues = [Value: LoweredValue]()
   var indirectReturn: Address?
+  /// The counters or counts for this function, if profiling.
+  let profile: FunctionProfile?
 
   lazy var trapBlock: BasicBlock = {
     let insertBlock = B.insertBlock!
@@ -102,10 +109,12 @@ final class IRGenGIRFunction: IRGenFunction {
     return block
   }()
 
-  init(irGenModule: IRGenModule, scope: OuterCore.Scope) {
-    self.schedule = Schedule(scope, .early)
+  init(irGenModule: IRGenModule, scope: OuterCore.Scope,
+       schedule: Schedule) {
+    self.schedule = schedule
     self.scope = scope
     let (f, fty) = irGenModule.function(for: scope.entry)
+    self.profile = irGenModule.profile(for: f, self.schedule)
     super.init(irGenModule, f, fty)
   }
 
@@ -115,7 +124,11 @@ final class IRGenGIRFunction: IRGenFunction {
     _ funcTy: Seismography.FunctionType,
     _ requiresIndirectResult: (GIRType) -> Bool
   ) -> [Seismography.Parameter] {
-    let directResultType = funcTy.returnType
+    // The return type is that of the return continuation; the result is
+    // the value passed to it, as in `LoweredSignature`.
+    // swiftlint:disable force_cast
+    let returnTy = funcTy.returnType as! Seismography.FunctionType
+    let directResultType = returnTy.arguments[0]
     if requiresIndirectResult(directResultType) {
       let retTI = self.IGM.getTypeInfo(directResultType)
       self.indirectReturn = retTI.address(for: params.claimSingle())
@@ -133,16 +146,20 @@ final class IRGenGIRFunction: IRGenFunction {
     return entry.parameters
   }
 
+  /// Claims the LLVM parameters that pass a formal parameter of the entry
+  /// continuation, and returns the values that bind its PHIs.
+  ///
+  /// A value passed indirectly is taken out of the buffer its parameter
+  /// points to, so this must be called with the builder in the prologue.
   func bindParameter(_ param: Seismography.Parameter,
-                     _ allParamValues: Explosion) {
+                     _ allParamValues: Explosion) -> Explosion {
     // Pull out the parameter value and its formal type.
     let paramTI = self.getTypeInfo(param.type)
+    let paramValues = Explosion()
     switch param.type.category {
     case .address:
-      let paramAddr = paramTI.address(for: allParamValues.claimSingle())
-      self.loweredValues[param] = .address(paramAddr)
+      paramValues.append(allParamValues.claimSingle())
     case .object:
-      let paramValues = Explosion()
       // If the explosion must be passed indirectly, load the value from the
       // indirect address.
       guard let loadableTI = paramTI as? LoadableTypeInfo else {
@@ -160,11 +177,10 @@ final class IRGenGIRFunction: IRGenFunction {
           assert(paramTI.schema.isEmpty)
         }
       }
-      self.loweredValues[param] = .explosion([IRValue](paramValues.claim()))
     }
+    return paramValues
   }
 
-
   func emitBody() {
     trace("emitting LLVM IR declaration for function '\(scope.entry.name)'") {
       guard let entryBlock = schedule.blocks.first else {
@@ -188,18 +204,30 @@ final class IRGenGIRFunction: IRGenFunction {
         return schema.isIndirect
       }
 
-      // Map remaining parameters to LLVM parameters.
-      for param in params.dropLast() {
-        self.bindParameter(param, expl)
-      }
-
       self.B.positionAtEnd(of: self.function.entryBlock!)
       let entryLBB = blockMap[entryBlock.parent]!
       let properEntry = self.function.entryBlock!
+      self.emitProfileEntry()
+      self.emitInstrumentationEntry()
+
+      // Map remaining parameters to LLVM parameters, and feed them into the
+      // PHIs of the entry continuation.  The indirect result, if any, has
+      // already been claimed, and values passed indirectly are loaded here,
+      // so the PHIs do not line up with the LLVM parameters one-to-one.
+      var phiIndex = 0
+      for param in params.dropLast() {
+        let paramValues = self.bindParameter(param, expl)
+        while !paramValues.isEmpty {
+          defer { phiIndex += 1 }
+          entryLBB.phis[phiIndex].addIncoming([
+            (paramValues.claimSingle(), properEntry),
+          ])
+        }
+      }
       self.B.buildBr(entryLBB.bb)
 
-      assert(expl.isEmpty || params.count == 1,
-             "didn't claim all parameters!")
+      assert(expl.isEmpty, "didn't claim all parameters!")
+      assert(phiIndex == entryLBB.phis.count, "didn't bind all PHIs!")
 
       for block in schedule.blocks {
         let bb = self.blockMap[block.parent]!
@@ -209,10 +237,7 @@ final class IRGenGIRFunction: IRGenFunction {
         }
       }
 
-      for (phi, param) in zip(entryLBB.phis, self.function.parameters) {
-        param.replaceAllUses(with: phi)
-        phi.addIncoming([ (param, properEntry) ])
-      }
+      self.addEffectAttributes()
     }
   }
 
@@ -10,7 +10,13 @@ import LLVM
 
 extension IRGenModule {
   /// Get or create a global variable.
+  ///
+  /// Distinct but structurally identical types share a mangled name, and so
+  /// the global that holds their metadata.
   func getOrCreateGlobalVariable(_ name: String, _ type: IRType) -> IRConstant {
+    if let existing = self.module.global(named: name) {
+      return existing
+    }
     return self.module.addGlobal(name, type: type)
   }
 }
@@ -202,6 +208,16 @@ extension ConstantBuilder {
       self.addRelativeOffset(to: target, type: .int32)
     }
 
+    /// Adds a relative address to the target, or zero if the target is a
+    /// null pointer.
+    func addRelativeAddressOrNull(to target: IRConstant) {
+      guard !target.isNull else {
+        self.addInt32(0)
+        return
+      }
+      self.addRelativeAddress(to: target)
+    }
+
     func addRelativeOffset(to target: IRConstant, type: IntType) {
       self.add(self.getRelativeOffset(type, target))
     }
@@ -486,6 +502,7 @@ fileprivate extension ConstantBuilder.Initializer {
     var GV = self.module.addGlobal(name, initializer: initializer,
                                    addressSpace: addressSpace)
     GV.linkage = linkage
+    GV.isGlobalConstant = constant
     GV.threadLocalModel = .notThreadLocal
     GV.alignment = alignment
     self.resolveSelfReferences(GV)
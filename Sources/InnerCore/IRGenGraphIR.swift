@@ -193,7 +193,10 @@ extension IRGenGIRFunction {
 
     // Emit the dispatch.
     let eis = self.datatypeStrategy(for: op.matchedValue.type)
-    eis.emitSwitch(self, inExplosion, dests, defaultDest)
+    let (switchDests, switchDefault) =
+      self.instrumentSwitch(op, dests, defaultDest)
+    eis.emitSwitch(self, inExplosion, switchDests, switchDefault)
+    self.annotateSwitch(op, switchDests, switchDefault)
 
     // Bind arguments for cases that want them.
     for (i, pat) in op.patterns.enumerated() {
@@ -0,0 +1,122 @@
+/// IRGenInstrumentation.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import LLVM
+import Lithosphere
+import Moho
+import Seismography
+import OuterCore
+
+/// The runtime operations IRGen instruments so Ferrite can attribute them to
+/// the place in the program that performed them.
+public struct IRGenInstrumentation: OptionSet {
+  public let rawValue: UInt32
+
+  public init(rawValue: UInt32) {
+    self.rawValue = rawValue
+  }
+
+  /// Heap allocations, reported by retained memory when the program exits.
+  public static let allocations = IRGenInstrumentation(rawValue: 1 << 0)
+
+  /// Retains, releases, copies and destroys, reported by call site when the
+  /// program exits along with retain/release pairs that cancel out.
+  public static let refcounting = IRGenInstrumentation(rawValue: 1 << 1)
+}
+
+extension IRGenModule {
+  /// Returns the address of a constant record describing an instrumented
+  /// operation, creating it if necessary.  The runtime identifies sites by
+  /// this address, so each function and detail gets exactly one record.
+  func addressOfInstrumentationSite(
+    in function: String, _ detail: String, at location: SourceLocation?
+  ) -> IRValue {
+    let key = InstrumentationSiteKey(function: function, detail: detail)
+    if let site = self.instrumentationSites[key] {
+      return site
+    }
+
+    let index = self.instrumentationSites.count
+    let name = "__silt_site_\(index)"
+    let fields: [IRValue] = [
+      self.siteString(function, name + "_function"),
+      self.siteString(detail, name + "_detail"),
+      location.map { self.siteString($0.file, name + "_file") }
+        ?? PointerType.toVoid.null(),
+      IntType.int32.constant(location?.line ?? 0),
+      IntType.int32.constant(location?.column ?? 0),
+    ]
+    var global = self.module.addGlobal(
+      name,
+      initializer: self.instrumentationSiteTy.constant(values: fields))
+    global.linkage = .private
+    global.isGlobalConstant = true
+    self.instrumentationSites[key] = global
+    return global
+  }
+
+  private func siteString(_ value: String, _ name: String) -> IRValue {
+    let bytes = ArrayType.constant(string: value, in: self.module.context)
+    var global = self.module.addGlobal(name, initializer: bytes)
+    global.linkage = .private
+    global.isGlobalConstant = true
+    return global.constGEP(indices: [
+      IntType.int32.constant(0), IntType.int32.constant(0)
+    ])
+  }
+}
+
+struct InstrumentationSiteKey: Hashable {
+  let function: String
+  let detail: String
+}
+
+extension IRGenFunction {
+  /// Returns a pointer to the site record for an instrumented operation in
+  /// this function.
+  ///
+  /// GraphIR does not carry source locations for individual primops, so a
+  /// site is identified by the enclosing function and a description of the
+  /// operation, and located at the function's definition.
+  func instrumentationSite(_ detail: String) -> IRValue {
+    guard let girFunction = self as? IRGenGIRFunction else {
+      let site = IGM.addressOfInstrumentationSite(in: self.function.name,
+                                                  detail, at: nil)
+      return self.B.buildBitCast(site, type: PointerType.toVoid)
+    }
+    let entry = girFunction.scope.entry
+    let location = IGM.sourceLocations.map { converter in
+      entry.name.name.syntax.startLocation(converter: converter)
+    }
+    let site = IGM.addressOfInstrumentationSite(in: entry.name.description,
+                                                detail, at: location)
+    return self.B.buildBitCast(site, type: PointerType.toVoid)
+  }
+
+  /// Begins a profiled invocation at the current insertion point, if
+  /// reference counting is instrumented.
+  func emitInstrumentationEntry() {
+    guard IGM.instrumentation.contains(.refcounting) else {
+      return
+    }
+    let enter = self.GR.emitIntrinsic(.refcountEnter)
+    self.refcountInvocation = self.B.buildCall(enter, args: [],
+                                               name: "invocation")
+  }
+
+  /// Returns the arguments that identify a reference counting operation to
+  /// its counting runtime entry point: a site for this call and the current
+  /// invocation.
+  func refcountSiteArguments(_ operation: String) -> [IRValue] {
+    let index = self.refcountSiteCount
+    self.refcountSiteCount += 1
+    return [
+      self.instrumentationSite("\(operation) #\(index)"),
+      self.refcountInvocation ?? IntType.int64.constant(0),
+    ]
+  }
+}
@@ -0,0 +1,164 @@
+/// IRGenJIT.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import cllvm
+import LLVM
+import Ferrite
+
+#if os(Linux)
+import Glibc
+#else
+import Darwin
+#endif
+
+/// An error raised while executing a module in-process.
+public enum JITError: Error, CustomStringConvertible {
+  /// The module has no `main` to run.
+  case noEntryPoint
+  /// A symbol referenced by the module could not be found.
+  case unresolvedSymbol(String)
+
+  public var description: String {
+    switch self {
+    case .noEntryPoint:
+      return "module has no entry point to run"
+    case let .unresolvedSymbol(name):
+      return "could not resolve symbol '\(name)'"
+    }
+  }
+}
+
+/// Executes modules produced by `IRGen.emit` in this process with LLVM's ORC
+/// JIT.
+///
+/// The compiler links Ferrite, so `silt_*` references are bound directly to
+/// the in-process runtime through the table it exports; anything else is
+/// looked up in the process's loaded images.
+public final class SiltJIT {
+  private let jit: JIT
+  private let runtimeSymbols: [String: UInt64]
+  private let processHandle: UnsafeMutableRawPointer?
+  private var unresolved: String?
+
+  /// Creates a JIT for the given host target machine.
+  ///
+  /// - Parameters:
+  ///   - targetMachine: The target machine to generate code with.
+  ///   - emitJITDump: If true, write a jitdump file describing each compiled
+  ///                  function so `perf inject --jit` can symbolize it.
+  public init(targetMachine: TargetMachine, emitJITDump: Bool) {
+    self.jit = JIT(machine: targetMachine)
+    self.processHandle = dlopen(nil, RTLD_NOW)
+
+    var symbols = [String: UInt64]()
+    var count = 0
+    if let table = silt_getRuntimeSymbols(&count) {
+      for entry in UnsafeBufferPointer(start: table, count: count) {
+        let name = self.jit.mangle(symbol: String(cString: entry.name))
+        symbols[name] = UInt64(UInt(bitPattern: entry.address))
+      }
+    }
+    self.runtimeSymbols = symbols
+
+    // N.B. The listener is only non-NULL if LLVM was built with perf support.
+    if emitJITDump, let listener = LLVMCreatePerfJITEventListener() {
+      LLVMOrcRegisterJITEventListener(self.jit.llvm, listener)
+    }
+  }
+
+  deinit {
+    if let handle = self.processHandle {
+      dlclose(handle)
+    }
+  }
+
+  /// Adds a module to the JIT.
+  ///
+  /// - Parameters:
+  ///   - module: The module to add.  The JIT takes ownership of it.
+  ///   - lazily: If true, each function is compiled the first time it is
+  ///             called rather than up front, so large modules start
+  ///             quickly.
+  ///
+  /// Every external the module declares is resolved before it is added, so
+  /// a missing symbol is reported here rather than when a lazily compiled
+  /// function first calls it.
+  public func add(_ module: Module, lazily: Bool) throws {
+    try self.resolveExternals(of: module)
+    let resolver: JIT.SymbolResolver = { [unowned self] name in
+      return TargetAddress(rawValue: self.resolve(name))
+    }
+    if lazily {
+      _ = try self.jit.addLazilyCompiledIR(module, resolver)
+    } else {
+      _ = try self.jit.addEagerlyCompiledIR(module, resolver)
+    }
+  }
+
+  /// Runs the module's C `main` and returns its exit status.
+  public func runMain() throws -> Int32 {
+    let address = try self.jit.address(of: self.jit.mangle(symbol: "main"))
+    if let name = self.unresolved {
+      throw JITError.unresolvedSymbol(name)
+    }
+    let bits = UInt(address.rawValue)
+    guard let entry = UnsafeRawPointer(bitPattern: bits) else {
+      throw JITError.noEntryPoint
+    }
+    typealias MainFn = @convention(c) () -> Int32
+    return unsafeBitCast(entry, to: MainFn.self)()
+  }
+
+  /// Resolves the functions and globals a module declares but does not
+  /// define, throwing if any of them cannot be found.
+  private func resolveExternals(of module: Module) throws {
+    var externals = [LLVMValueRef]()
+    var function = LLVMGetFirstFunction(module.llvm)
+    while let fn = function {
+      function = LLVMGetNextFunction(fn)
+      externals.append(fn)
+    }
+    var global = LLVMGetFirstGlobal(module.llvm)
+    while let gv = global {
+      global = LLVMGetNextGlobal(gv)
+      externals.append(gv)
+    }
+
+    for value in externals where LLVMIsDeclaration(value) != 0 {
+      // Intrinsics are lowered by the code generator, not linked.
+      guard LLVMGetIntrinsicID(value) == 0 else {
+        continue
+      }
+      var length = 0
+      guard let cName = LLVMGetValueName2(value, &length) else {
+        continue
+      }
+      let name = self.jit.mangle(symbol: String(cString: cName))
+      guard self.resolve(name) != 0 else {
+        throw JITError.unresolvedSymbol(name)
+      }
+    }
+  }
+
+  private func resolve(_ name: String) -> UInt64 {
+    if let address = self.runtimeSymbols[name] {
+      return address
+    }
+
+    #if os(macOS)
+    // Strip the global prefix the JIT added before asking dyld.
+    let symbol = name.hasPrefix("_") ? String(name.dropFirst()) : name
+    #else
+    let symbol = name
+    #endif
+    if let address = dlsym(self.processHandle, symbol) {
+      return UInt64(UInt(bitPattern: address))
+    }
+    self.unresolved = self.unresolved ?? name
+    return 0
+  }
+}
@@ -32,15 +32,24 @@ extension IRGenModule {
   ///   - otherwise it will be adjusted to the canonical address point
   ///     for a type metadata and it will have type TypeMetadataPtrTy.
   func getOrCreateTypeMetadata(_ concreteType: GIRType) -> IRConstant {
-    var mangler = GIRMangler()
-    concreteType.mangle(into: &mangler)
-    mangler.append("N")
-    let addr = self.getOrCreateGlobalVariable(mangler.finalize(),
-                                              self.fullTypeMetadataStructTy)
-    return addr.constGEP(indices: [
-      IntType.int32.zero(),       // (*Self)
-      IntType.int32.constant(1),  // .metadata
-    ])
+    return self.typeMetadataCache.entry(for: concreteType) {
+      let name = self.mangledName(of: concreteType) + "N"
+      let addr = self.getOrCreateGlobalVariable(name,
+                                                self.fullTypeMetadataStructTy)
+      return addr.constGEP(indices: [
+        IntType.int32.zero(),       // (*Self)
+        IntType.int32.constant(1),  // .metadata
+      ])
+    }
+  }
+
+  /// Returns the mangling of a type, without any suffix.
+  func mangledName(of type: GIRType) -> String {
+    return self.mangledNameCache.entry(for: type) {
+      var mangler = GIRMangler()
+      type.mangle(into: &mangler)
+      return mangler.finalize()
+    }
   }
 }
 
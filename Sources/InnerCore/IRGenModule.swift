@@ -6,7 +6,9 @@
 /// available in the repository.
 
 import cllvm
+import Dispatch
 import LLVM
+import Lithosphere
 import Seismography
 import OuterCore
 import PrettyStackTrace
@@ -21,6 +23,31 @@ final class IRGenModule {
 
   var stringsForTypeRef = [String: (IRGlobal, IRConstant)]()
 
+  let profileMode: ProfileMode
+  /// The counters of instrumented functions, in emission order.
+  var profileRecords = [ProfileRecord]()
+  /// The recorded counts of every function a profile was applied to.
+  var profileCounts = [[UInt64]]()
+
+  let instrumentation: IRGenInstrumentation
+  /// Locates the definitions of instrumented functions, if available.
+  let sourceLocations: SourceLocationConverter?
+  /// The site record of every instrumented operation, by function and detail.
+  var instrumentationSites = [InstrumentationSiteKey: IRValue]()
+  /// The IR type of an instrumentation site record.  This layout must match
+  /// `InstrumentationSite` in the Ferrite headers.
+  lazy var instrumentationSiteTy: StructType =
+    self.B.createStruct(name: "silt.site", types: [
+      PointerType.toVoid,   // const char *function
+      PointerType.toVoid,   // const char *detail
+      PointerType.toVoid,   // const char *file
+      IntType.int32,        // uint32_t line
+      IntType.int32,        // uint32_t column
+    ])
+
+  /// The type-based alias analysis tag of each class of memory access.
+  var tbaaTags = [AliasClass: LLVMValueRef]()
+
   let sizeTy: IntType
   let typeMetadataStructTy: StructType
   let typeMetadataPtrTy: PointerType
@@ -35,7 +62,22 @@ final class IRGenModule {
 
   private(set) var scopeMap = [OuterCore.Scope: IRGenFunction]()
 
-  init(module: GIRModule) {
+  /// How often the caches below spared IRGen from recomputing an entry.
+  let statistics: IRGenStatistics
+  /// The mangled name of each type whose metadata has been referenced.
+  let mangledNameCache: TypeIdentityCache<String>
+  /// The address point of each type's metadata.
+  let typeMetadataCache: TypeIdentityCache<IRConstant>
+  /// The complete type info of each lowered type.
+  let typeInfoCache: TypeIdentityCache<TypeInfo>
+
+  init(
+    module: GIRModule, targetMachine: TargetMachine? = nil,
+    profileMode: ProfileMode = .none,
+    instrumentation: IRGenInstrumentation = [],
+    sourceLocations: SourceLocationConverter? = nil,
+    statistics: IRGenStatistics = IRGenStatistics()
+  ) {
     initializeLLVM()
 
     LLVMInstallFatalErrorHandler { msg in
@@ -44,7 +86,17 @@ final class IRGenModule {
       exit(EXIT_FAILURE)
     }
     self.girModule = module
+    self.profileMode = profileMode
+    self.instrumentation = instrumentation
+    self.sourceLocations = sourceLocations
+    self.statistics = statistics
+    self.mangledNameCache = TypeIdentityCache(statistics, \.mangledNames)
+    self.typeMetadataCache = TypeIdentityCache(statistics, \.typeMetadata)
+    self.typeInfoCache = TypeIdentityCache(statistics, \.typeInfo)
     self.module = Module(name: girModule.name)
+    if let targetMachine = targetMachine {
+      IRGen.configureTarget(of: self.module, for: targetMachine)
+    }
 
     self.B = IRBuilder(module: self.module)
     self.dataLayout = self.module.dataLayout
@@ -66,14 +118,18 @@ final class IRGenModule {
     self.opaquePtrTy =
       PointerType(pointee: self.B.createStruct(name: "silt.opaque"))
     self.witnessTablePtrTy = PointerType(pointee: PointerType.toVoid)
+    // Type metadata is emitted as constant data, so the witness table is
+    // referenced with a relative pointer that needs no relocation.
     self.fullTypeMetadataStructTy = self.B.createStruct(name: "silt.full_type",
                                                         types: [
-      self.witnessTablePtrTy,
+      IntType.int32,                 // RelativeDirectPointer ValueWitnesses
       self.typeMetadataStructTy,
     ])
     self.fullTypeMetadataPtrTy =
       PointerType(pointee: self.fullTypeMetadataStructTy)
-    // A tuple type metadata record has a couple extra fields.
+    // A tuple type metadata record has a couple extra fields.  These keep
+    // absolute pointers: tuple metadata is instantiated at runtime, on the
+    // heap, where a 32-bit offset may not reach the static data.
     let tupleElementTy = self.B.createStruct(name: "silt.tuple_element_type",
                                              types: [
       self.typeMetadataPtrTy,      // Metadata *Type
@@ -90,24 +146,73 @@ final class IRGenModule {
   }
 
   func getTypeInfo(_ ty: GIRType) -> TypeInfo {
-    return self.typeConverter.getCompleteTypeInfo(ty)
+    return self.typeInfoCache.entry(for: ty) {
+      return self.typeConverter.getCompleteTypeInfo(ty)
+    }
   }
 
   func emit() {
     trace("emitting LLVM IR for module '\(girModule.name)'") {
-      for scope in girModule.topLevelScopes {
-        let igf = IRGenGIRFunction(irGenModule: self, scope: scope)
+      let scopes = girModule.topLevelScopes
+      for (scope, schedule) in zip(scopes, self.schedule(scopes)) {
+        let igf = IRGenGIRFunction(irGenModule: self, scope: scope,
+                                   schedule: schedule)
         igf.emitBody()
       }
+      self.emitProfileSummary()
+    }
+  }
+
+  /// Schedules each scope on its own thread.
+  ///
+  /// Scheduling only reads the graph, so unlike the emission of LLVM IR,
+  /// which shares this module's LLVM context and type caches, it can run
+  /// concurrently.
+  private func schedule(_ scopes: [OuterCore.Scope]) -> [Schedule] {
+    var schedules = [Schedule?](repeating: nil, count: scopes.count)
+    schedules.withUnsafeMutableBufferPointer { schedules in
+      DispatchQueue.concurrentPerform(iterations: scopes.count) { index in
+        schedules[index] = Schedule(scopes[index], .early)
+      }
     }
+    return schedules.map { $0! }
   }
 
   func emitMain() {
     let fn = B.addFunction("main", type: FunctionType([], IntType.int32))
     let entry = fn.appendBasicBlock(named: "entry")
     B.positionAtEnd(of: entry)
+    let instrumented = self.emitProfileRegistration()
+    if let siltMain = self.entryPoint() {
+      // If the result is returned indirectly, give it somewhere to go.
+      var args = [IRValue]()
+      for param in siltMain.parameters {
+        guard let resultTy = param.type as? PointerType else {
+          fatalError("entry point takes a non-indirect parameter")
+        }
+        args.append(B.buildAlloca(type: resultTy.pointee, name: "result"))
+      }
+      _ = B.buildCall(siltMain, args: args)
+    }
+    if instrumented {
+      _ = B.buildCall(self.runtimeFunction(.profileWrite), args: [])
+    }
     B.buildRet(0 as Int32)
   }
+
+  /// Finds the function named `main` in the module, if it takes no
+  /// arguments.  The generated C `main` calls it.
+  private func entryPoint() -> Function? {
+    let candidate = self.girModule.continuations.first { cont in
+      return cont.bblikeSuffix == nil
+          && cont.baseName == "main"
+          && cont.parameters.count == 1
+    }
+    guard let entry = candidate else {
+      return nil
+    }
+    return self.function(for: entry).0
+  }
 }
 
 extension IRGenModule {
@@ -135,6 +240,8 @@ extension IRGenModule {
       return (fn, signature.type)
     }
 
-    return (self.B.addFunction(key, type: signature.type), signature.type)
+    let fn = self.B.addFunction(key, type: signature.type)
+    signature.addAttributes(to: fn)
+    return (fn, signature.type)
   }
 }
@@ -0,0 +1,375 @@
+/// IRGenPartition.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Dispatch
+import cllvm
+import LLVM
+import OuterCore
+
+/// An error raised while generating code for part of a module.
+public enum PartitionError: Error, CustomStringConvertible {
+  /// A partition's bitcode could not be read back in its own context.
+  case invalidBitcode(partition: Int)
+  /// A partition failed to verify.
+  case invalidPartition(partition: Int, String)
+  /// LLVM could not create a target machine for a partition.
+  case noTarget(String)
+  /// LLVM failed to emit a partition's object file.
+  case emitFailed(partition: Int, String)
+
+  public var description: String {
+    switch self {
+    case let .invalidBitcode(partition):
+      return "could not read back the bitcode of partition \(partition)"
+    case let .invalidPartition(partition, message):
+      return "partition \(partition) is invalid: \(message)"
+    case let .noTarget(message):
+      return "could not create a target machine: \(message)"
+    case let .emitFailed(partition, message):
+      return "could not emit partition \(partition): \(message)"
+    }
+  }
+}
+
+extension IRGen {
+  /// The least code, in LLVM instructions, worth giving a thread of its own
+  /// by default.  Splitting a module costs a copy of it per partition, which
+  /// smaller partitions do not repay.
+  public static let defaultMinimumPartitionSize = 5_000
+
+  /// Emits a module as native object files, generating code for separate
+  /// parts of the module on separate threads.
+  ///
+  /// An LLVM context may only be used by one thread at a time, so each part
+  /// is copied into a context of its own through bitcode.  Functions with
+  /// external linkage are divided between the parts; every other definition
+  /// is left in all of them.  Global variables are defined by the first part
+  /// and visible to the others as `available_externally` copies.  Internal
+  /// symbols become hidden so the parts can refer to each other's.
+  ///
+  /// The module is modified and must not be used afterwards.  In debug
+  /// builds, each part is verified before code is generated for it.
+  ///
+  /// - Parameters:
+  ///   - module: The optimized module to emit.
+  ///   - targetMachine: The machine to generate code for.  Each thread uses
+  ///                    its own copy.
+  ///   - level: The optimization level the copies generate code at.
+  ///   - relocationModel: The relocation model `targetMachine` was created
+  ///                      with, which the copies share.
+  ///   - threads: The most threads to use.
+  ///   - minimumPartitionSize: The least code, in LLVM instructions, to give
+  ///                           a thread of its own.
+  ///   - prefix: The path of the object files, without an extension.
+  /// - Returns: The paths of the object files written.
+  public static func emitObjects(
+    _ module: Module, targetMachine: TargetMachine, level: OptimizationLevel,
+    relocationModel: RelocMode, threads: Int,
+    minimumPartitionSize: Int = IRGen.defaultMinimumPartitionSize,
+    toFilesWithPrefix prefix: String
+  ) throws -> [String] {
+    let partitions = self.partition(module.llvm, into: threads,
+                                    minimumSize: minimumPartitionSize)
+    guard partitions.count > 1 else {
+      let path = prefix + ".o"
+      try self.emitObject(module, targetMachine: targetMachine, to: path)
+      return [path]
+    }
+    try module.verify()
+
+    let bitcode = partitions.indices.map { index in
+      return self.splitBitcode(module.llvm, partitions, index)
+    }
+    defer { bitcode.forEach { LLVMDisposeMemoryBuffer($0) } }
+
+    let paths = partitions.indices.map { "\(prefix).\($0).o" }
+    var errors = [PartitionError?](repeating: nil, count: partitions.count)
+    let machine = MachineDescription(targetMachine.llvm, level,
+                                     relocationModel)
+    errors.withUnsafeMutableBufferPointer { errors in
+      DispatchQueue.concurrentPerform(iterations: partitions.count) { index in
+        errors[index] = machine.emit(bitcode[index], index, to: paths[index])
+      }
+    }
+    if let error = errors.lazy.compactMap({ $0 }).first {
+      throw error
+    }
+    return paths
+  }
+
+  /// Divides the functions a module defines with external linkage between
+  /// at most `threads` partitions of roughly equal size, with at least
+  /// `minimumSize` instructions of the module for each.
+  ///
+  /// Internal definitions are made hidden first, so the partitions are
+  /// computed over the final set of external functions.
+  private static func partition(
+    _ module: LLVMModuleRef, into threads: Int, minimumSize: Int
+  ) -> [Set<String>] {
+    // Aliases must stay with their aliasees, and nothing emitted by IRGen
+    // uses them.  Modules that have some are not split.
+    guard threads > 1, LLVMGetFirstGlobalAlias(module) == nil else {
+      return []
+    }
+
+    var candidates = 0
+    var totalSize = 0
+    var function = LLVMGetFirstFunction(module)
+    while let fn = function {
+      function = LLVMGetNextFunction(fn)
+      guard LLVMIsDeclaration(fn) == 0 else {
+        continue
+      }
+      totalSize += self.instructionCount(fn)
+      if LLVMGetLinkage(fn) == LLVMExternalLinkage
+          || self.hasLocalLinkage(fn) {
+        candidates += 1
+      }
+    }
+
+    let count = min(threads, candidates, totalSize / max(minimumSize, 1))
+    guard count > 1 else {
+      return []
+    }
+
+    self.externalizeLocalDefinitions(in: module)
+    var functions = [(name: String, size: Int)]()
+    function = LLVMGetFirstFunction(module)
+    while let fn = function {
+      function = LLVMGetNextFunction(fn)
+      guard LLVMIsDeclaration(fn) == 0,
+            LLVMGetLinkage(fn) == LLVMExternalLinkage else {
+        continue
+      }
+      functions.append((self.valueName(fn), self.instructionCount(fn)))
+    }
+
+    // Place the largest functions first, each in the smallest partition.
+    var partitions = [Set<String>](repeating: [], count: count)
+    var sizes = [Int](repeating: 0, count: count)
+    for (name, size) in functions.sorted(by: { $0.size > $1.size }) {
+      let smallest = sizes.indices.min { sizes[$0] < sizes[$1] }!
+      partitions[smallest].insert(name)
+      sizes[smallest] += size
+    }
+    return partitions
+  }
+
+  /// Gives every internal or private definition in a module a unique name
+  /// and hidden, external linkage.
+  private static func externalizeLocalDefinitions(in module: LLVMModuleRef) {
+    var unnamed = 0
+    func externalize(_ value: LLVMValueRef) {
+      guard LLVMIsDeclaration(value) == 0, self.hasLocalLinkage(value) else {
+        return
+      }
+      var name = self.valueName(value)
+      if name.isEmpty {
+        name = "__silt_local.\(unnamed)"
+        unnamed += 1
+      } else {
+        // Keep clear of the runtime library's own external symbols.
+        name += ".silt.local"
+      }
+      LLVMSetValueName2(value, name, name.utf8.count)
+      LLVMSetLinkage(value, LLVMExternalLinkage)
+      LLVMSetVisibility(value, LLVMHiddenVisibility)
+    }
+
+    var function = LLVMGetFirstFunction(module)
+    while let fn = function {
+      externalize(fn)
+      function = LLVMGetNextFunction(fn)
+    }
+    var global = LLVMGetFirstGlobal(module)
+    while let gv = global {
+      externalize(gv)
+      global = LLVMGetNextGlobal(gv)
+    }
+  }
+
+  /// Returns the bitcode of a copy of the module that defines only the
+  /// external functions in the given partition.
+  private static func splitBitcode(
+    _ module: LLVMModuleRef, _ partitions: [Set<String>], _ index: Int
+  ) -> LLVMMemoryBufferRef {
+    let copy = LLVMCloneModule(module)!
+    defer { LLVMDisposeModule(copy) }
+
+    let owned = partitions[index]
+    var function = LLVMGetFirstFunction(copy)
+    while let fn = function {
+      function = LLVMGetNextFunction(fn)
+      guard LLVMIsDeclaration(fn) == 0,
+            LLVMGetLinkage(fn) == LLVMExternalLinkage,
+            !owned.contains(self.valueName(fn)) else {
+        continue
+      }
+      self.deleteBody(of: fn)
+    }
+
+    guard index != 0 else {
+      return LLVMWriteBitcodeToMemoryBuffer(copy)
+    }
+    var global = LLVMGetFirstGlobal(copy)
+    while let gv = global {
+      global = LLVMGetNextGlobal(gv)
+      guard LLVMIsDeclaration(gv) == 0 else {
+        continue
+      }
+      switch LLVMGetLinkage(gv) {
+      case LLVMExternalLinkage:
+        LLVMSetLinkage(gv, LLVMAvailableExternallyLinkage)
+      case LLVMAppendingLinkage:
+        // Constructor lists and the like belong to the first partition.
+        LLVMDeleteGlobal(gv)
+      default:
+        break
+      }
+    }
+    LLVMSetModuleInlineAsm2(copy, "", 0)
+    return LLVMWriteBitcodeToMemoryBuffer(copy)
+  }
+
+  /// Turns a function definition into a declaration.
+  ///
+  /// Attachments only valid on definitions, such as profile counts, debug
+  /// info, personalities and COMDATs, are removed with the body.
+  private static func deleteBody(of function: LLVMValueRef) {
+    // Instructions may only be erased once nothing uses them, and blocks
+    // once no terminator branches to them.
+    var block = LLVMGetFirstBasicBlock(function)
+    while let bb = block {
+      var instruction = LLVMGetFirstInstruction(bb)
+      while let inst = instruction {
+        let type = LLVMTypeOf(inst)
+        if LLVMGetTypeKind(type) != LLVMVoidTypeKind {
+          LLVMReplaceAllUsesWith(inst, LLVMGetUndef(type))
+        }
+        instruction = LLVMGetNextInstruction(inst)
+      }
+      block = LLVMGetNextBasicBlock(bb)
+    }
+    block = LLVMGetFirstBasicBlock(function)
+    while let bb = block {
+      var instruction = LLVMGetFirstInstruction(bb)
+      while let inst = instruction {
+        instruction = LLVMGetNextInstruction(inst)
+        LLVMInstructionEraseFromParent(inst)
+      }
+      block = LLVMGetNextBasicBlock(bb)
+    }
+    block = LLVMGetFirstBasicBlock(function)
+    while let bb = block {
+      block = LLVMGetNextBasicBlock(bb)
+      LLVMDeleteBasicBlock(bb)
+    }
+    LLVMGlobalClearMetadata(function)
+    LLVMSetPersonalityFn(function, nil)
+    LLVMSetComdat(function, nil)
+    LLVMSetLinkage(function, LLVMExternalLinkage)
+  }
+
+  private static func instructionCount(_ function: LLVMValueRef) -> Int {
+    var count = 0
+    var block = LLVMGetFirstBasicBlock(function)
+    while let bb = block {
+      var instruction = LLVMGetFirstInstruction(bb)
+      while let inst = instruction {
+        count += 1
+        instruction = LLVMGetNextInstruction(inst)
+      }
+      block = LLVMGetNextBasicBlock(bb)
+    }
+    return count
+  }
+
+  private static func hasLocalLinkage(_ value: LLVMValueRef) -> Bool {
+    let linkage = LLVMGetLinkage(value)
+    return linkage == LLVMInternalLinkage || linkage == LLVMPrivateLinkage
+  }
+
+  private static func valueName(_ value: LLVMValueRef) -> String {
+    var length = 0
+    guard let name = LLVMGetValueName2(value, &length) else {
+      return ""
+    }
+    return String(cString: name)
+  }
+}
+
+/// Everything needed to recreate a target machine on another thread.
+private struct MachineDescription {
+  let triple: String
+  let cpu: String
+  let features: String
+  let level: CodeGenOptLevel
+  let relocationModel: RelocMode
+
+  init(
+    _ machine: LLVMTargetMachineRef, _ level: OptimizationLevel,
+    _ relocationModel: RelocMode
+  ) {
+    func take(_ string: UnsafeMutablePointer<Int8>?) -> String {
+      defer { LLVMDisposeMessage(string) }
+      return string.map { String(cString: $0) } ?? ""
+    }
+    self.triple = take(LLVMGetTargetMachineTriple(machine))
+    self.cpu = take(LLVMGetTargetMachineCPU(machine))
+    self.features = take(LLVMGetTargetMachineFeatureString(machine))
+    self.level = level.codeGenOptLevel
+    self.relocationModel = relocationModel
+  }
+
+  /// Reads a partition into a fresh context and emits it as an object file.
+  func emit(
+    _ bitcode: LLVMMemoryBufferRef, _ index: Int, to path: String
+  ) -> PartitionError? {
+    let context = LLVMContextCreate()
+    defer { LLVMContextDispose(context) }
+    var parsed: LLVMModuleRef?
+    guard
+      LLVMParseBitcodeInContext2(context, bitcode, &parsed) == 0,
+      let module = parsed
+    else {
+      return .invalidBitcode(partition: index)
+    }
+    defer { LLVMDisposeModule(module) }
+
+    var message: UnsafeMutablePointer<Int8>?
+    #if DEBUG
+    if LLVMVerifyModule(module, LLVMReturnStatusAction, &message) != 0 {
+      defer { LLVMDisposeMessage(message) }
+      return .invalidPartition(partition: index,
+                               message.map { String(cString: $0) } ?? "")
+    }
+    LLVMDisposeMessage(message)
+    message = nil
+    #endif
+
+    let machine: TargetMachine
+    do {
+      machine = try TargetMachine(
+        triple: self.triple, cpu: self.cpu, features: self.features,
+        optLevel: self.level, relocMode: self.relocationModel)
+    } catch {
+      return .noTarget("\(error)")
+    }
+
+    let failed = path.withCString { path in
+      return LLVMTargetMachineEmitToFile(
+        machine.llvm, module, UnsafeMutablePointer(mutating: path),
+        LLVMObjectFile, &message) != 0
+    }
+    guard failed else {
+      return nil
+    }
+    defer { LLVMDisposeMessage(message) }
+    return .emitFailed(partition: index,
+                       message.map { String(cString: $0) } ?? "")
+  }
+}
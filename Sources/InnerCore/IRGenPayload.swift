@@ -142,7 +142,8 @@ extension Payload {
     let address = IGF.B.createPointerBitCast(of: address, to: ptrTy)
 
     if result.payloadValues.count == 1 {
-      let val = IGF.B.createLoad(address, alignment: address.alignment)
+      let val = IGF.emitLoad(address, alignment: address.alignment,
+                             as: .value)
       result.payloadValues[0] = .left(val)
     } else {
       var offset = Size.zero
@@ -150,8 +151,8 @@ extension Payload {
       loadedPayloads.reserveCapacity(result.payloadValues.count)
       for i in result.payloadValues.indices {
         let member = IGF.B.createStructGEP(address, i, offset, "")
-        let loadedValue =  IGF.B.createLoad(member,
-                                            alignment: member.alignment)
+        let loadedValue = IGF.emitLoad(member, alignment: member.alignment,
+                                       as: .value)
         loadedPayloads.append(.left(loadedValue))
         offset += Size(IGF.IGM.dataLayout.allocationSize(of: loadedValue.type))
       }
@@ -171,15 +172,15 @@ extension Payload {
     let address = IGF.B.createPointerBitCast(of: address, to: ptrTy)
 
     if self.payloadValues.count == 1 {
-      IGF.B.buildStore(forcePayloadValue(self.payloadValues[0]),
-                       to: address.address)
+      IGF.emitStore(forcePayloadValue(self.payloadValues[0]),
+                    to: address, as: .value)
       return
     } else {
       var offset = Size.zero
       for (i, value) in self.payloadValues.enumerated() {
         let member = IGF.B.createStructGEP(address, i, offset, "")
         let valueToStore = forcePayloadValue(value)
-        IGF.B.buildStore(valueToStore, to: member.address)
+        IGF.emitStore(valueToStore, to: member, as: .value)
         offset += Size(IGF.IGM.dataLayout.allocationSize(of: valueToStore.type))
       }
     }
@@ -0,0 +1,422 @@
+/// IRGenProfile.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import cllvm
+import Foundation
+import LLVM
+import Seismography
+import OuterCore
+
+/// How IRGen uses execution profiles of the program being compiled.
+public enum ProfileMode {
+  /// Emit no instrumentation and consult no profile.
+  case none
+
+  /// Count entries to every function and the cases taken by every
+  /// `switch_constr`.  The program writes its counters to `path` when it
+  /// exits, unless `SILT_PROFILE_FILE` names another file.
+  case generate(path: String)
+
+  /// Annotate the module with the counts recorded by an instrumented build
+  /// so LLVM's block placement and inliner can act on them.
+  case use(ProfileData)
+}
+
+public enum ProfileError: Error, CustomStringConvertible {
+  case unreadable(URL)
+  case malformed(URL, line: Int)
+
+  public var description: String {
+    switch self {
+    case let .unreadable(url):
+      return "could not read '\(url.path)'"
+    case let .malformed(url, line):
+      return "'\(url.path)' is not a Silt profile (line \(line))"
+    }
+  }
+}
+
+/// The counters read from a profile written by an instrumented program.
+///
+/// The file format is the one written by Ferrite's `silt_profile_write`: a
+/// header line followed by one line per function holding its mangled name,
+/// its control-flow hash, the number of counters, and the counters.
+public struct ProfileData {
+  fileprivate struct Record {
+    let hash: UInt64
+    let counters: [UInt64]
+  }
+
+  fileprivate static let header = "# silt profile v1"
+
+  fileprivate let records: [String: Record]
+
+  public init(contentsOf url: URL) throws {
+    guard let contents = try? String(contentsOf: url, encoding: .utf8) else {
+      throw ProfileError.unreadable(url)
+    }
+    let lines = contents.split(separator: "\n",
+                               omittingEmptySubsequences: false)
+    guard lines.first.map(String.init) == ProfileData.header else {
+      throw ProfileError.malformed(url, line: 1)
+    }
+
+    var records = [String: Record]()
+    for (index, line) in lines.enumerated().dropFirst() where !line.isEmpty {
+      let fields = line.split(separator: " ")
+      guard
+        fields.count >= 3,
+        let hash = UInt64(fields[1]),
+        let count = Int(fields[2]),
+        fields.count == 3 + count
+      else {
+        throw ProfileError.malformed(url, line: index + 1)
+      }
+      let counters = fields[3...].compactMap { UInt64($0) }
+      guard counters.count == count else {
+        throw ProfileError.malformed(url, line: index + 1)
+      }
+      records[String(fields[0])] = Record(hash: hash, counters: counters)
+    }
+    self.records = records
+  }
+
+  /// Retrieves the counters recorded for a function, if the function has not
+  /// changed shape since it was profiled.
+  fileprivate func counters(for name: String, hash: UInt64) -> [UInt64]? {
+    guard let record = self.records[name], record.hash == hash else {
+      return nil
+    }
+    return record.counters
+  }
+}
+
+/// The assignment of counters to the points IRGen instruments in a function.
+///
+/// The first counter counts entries to the function.  Each `switch_constr`,
+/// in schedule order, then gets one counter per pattern followed by one for
+/// its default destination, if it has one.
+struct FunctionProfileLayout {
+  /// The index of the first counter of each `switch_constr`.
+  let switchOffsets: [SwitchConstrOp: Int]
+  /// The total number of counters.
+  let counterCount: Int
+  /// A hash of the instrumented control flow.  A profile is only applied to a
+  /// function with the same hash as the one that recorded it.
+  let hash: UInt64
+
+  init(_ schedule: Schedule) {
+    var offsets = [SwitchConstrOp: Int]()
+    var caseCounts = [UInt64]()
+    var next = 1
+    for block in schedule.blocks {
+      for case let op as SwitchConstrOp in block.primops {
+        let cases = op.patterns.count + (op.default == nil ? 0 : 1)
+        offsets[op] = next
+        caseCounts.append(UInt64(cases))
+        next += cases
+      }
+    }
+    self.switchOffsets = offsets
+    self.counterCount = next
+
+    // FNV-1a over the number of cases at each site.
+    var hash: UInt64 = 0xcbf29ce484222325
+    for value in [UInt64(caseCounts.count)] + caseCounts {
+      hash = (hash ^ value) &* 0x100000001b3
+    }
+    self.hash = hash
+  }
+}
+
+/// The profiling state of a function being emitted.
+enum FunctionProfile {
+  /// The function increments the given array of counters.
+  case instrumented(FunctionProfileLayout, counters: Global)
+  /// The function is annotated with previously recorded counts.
+  case profiled(FunctionProfileLayout, counts: [UInt64])
+}
+
+/// A function whose counters are registered with the runtime.
+struct ProfileRecord {
+  let name: String
+  let hash: UInt64
+  let counters: Global
+  let counterCount: Int
+}
+
+extension IRGenModule {
+  /// Determines how a function should be profiled, allocating its counters
+  /// if the module is instrumented.
+  func profile(
+    for function: Function, _ schedule: Schedule
+  ) -> FunctionProfile? {
+    switch self.profileMode {
+    case .none:
+      return nil
+    case .generate(_):
+      let layout = FunctionProfileLayout(schedule)
+      let countersTy = ArrayType(elementType: IntType.int64,
+                                 count: layout.counterCount)
+      var counters = self.module.addGlobal("__silt_prof_cnts_" + function.name,
+                                           initializer: countersTy.null())
+      counters.linkage = .private
+      self.profileRecords.append(ProfileRecord(
+        name: function.name, hash: layout.hash, counters: counters,
+        counterCount: layout.counterCount))
+      return .instrumented(layout, counters: counters)
+    case let .use(data):
+      let layout = FunctionProfileLayout(schedule)
+      guard
+        let counts = data.counters(for: function.name, hash: layout.hash),
+        counts.count == layout.counterCount
+      else {
+        return nil
+      }
+      self.profileCounts.append(counts)
+      return .profiled(layout, counts: counts)
+    }
+  }
+
+  /// Emits the table of counters and registers it with the runtime at the
+  /// current insertion point.  Returns `false` if the module is not
+  /// instrumented.
+  func emitProfileRegistration() -> Bool {
+    guard case let .generate(path) = self.profileMode else {
+      return false
+    }
+
+    let recordTy = self.B.createStruct(name: "silt.profile_data", types: [
+      PointerType.toVoid,                     // const char *name
+      IntType.int64,                          // uint64_t hash
+      IntType.int64,                          // uint64_t numCounters
+      PointerType(pointee: IntType.int64),    // uint64_t *counters
+    ])
+    let records: [IRValue] = self.profileRecords.map { record in
+      let name = self.profileString(record.name,
+                                    "__silt_prof_name_" + record.name)
+      let counters = record.counters.constGEP(indices: [
+        IntType.int32.constant(0), IntType.int32.constant(0)
+      ])
+      return recordTy.constant(values: [
+        name,
+        IntType.int64.constant(record.hash),
+        IntType.int64.constant(record.counterCount),
+        counters,
+      ])
+    }
+    var table = self.module.addGlobal(
+      "__silt_prof_data",
+      initializer: ArrayType.constant(records, type: recordTy))
+    table.linkage = .private
+
+    let register = self.runtimeFunction(.profileRegister)
+    _ = self.B.buildCall(register, args: [
+      self.B.buildBitCast(table, type: PointerType.toVoid),
+      IntType.int64.constant(self.profileRecords.count),
+      self.profileString(path, "__silt_prof_filename"),
+    ])
+    return true
+  }
+
+  /// Attaches the profile summary LLVM uses to decide which functions and
+  /// call sites are hot.
+  func emitProfileSummary() {
+    guard case .use(_) = self.profileMode, !self.profileCounts.isEmpty else {
+      return
+    }
+
+    let entryCounts = self.profileCounts.map { $0[0] }
+    let internalCounts = self.profileCounts.flatMap { $0.dropFirst() }
+    let allCounts = self.profileCounts.flatMap { $0 }.sorted(by: >)
+    let total = allCounts.reduce(0, &+)
+
+    // The detailed summary records, for each cutoff (in parts per million of
+    // the total count), the smallest count needed to reach it.
+    let cutoffs: [UInt64] = [
+      10000, 100000, 200000, 300000, 400000, 500000, 600000, 700000, 800000,
+      900000, 950000, 990000, 999000, 999900, 999990, 999999,
+    ]
+    var detailed = [LLVMValueRef?]()
+    var consumed = 0
+    var accumulated: UInt64 = 0
+    for cutoff in cutoffs {
+      let desired = Double(total) * Double(cutoff) / 1_000_000
+      while consumed < allCounts.count && Double(accumulated) < desired {
+        accumulated = accumulated &+ allCounts[consumed]
+        consumed += 1
+      }
+      let minCount = consumed == 0 ? 0 : allCounts[consumed - 1]
+      detailed.append(self.metadataNode([
+        IntType.int32.constant(cutoff).asLLVM(),
+        IntType.int64.constant(minCount).asLLVM(),
+        IntType.int32.constant(consumed).asLLVM(),
+      ]))
+    }
+
+    func entry(_ key: String, _ value: UInt64) -> LLVMValueRef {
+      return self.metadataNode([
+        self.metadataString(key), IntType.int64.constant(value).asLLVM()
+      ])
+    }
+    let summary = self.metadataNode([
+      self.metadataNode([
+        self.metadataString("ProfileFormat"),
+        self.metadataString("InstrProf"),
+      ]),
+      entry("TotalCount", total),
+      entry("MaxCount", allCounts.first ?? 0),
+      entry("MaxInternalCount", internalCounts.max() ?? 0),
+      entry("MaxFunctionCount", entryCounts.max() ?? 0),
+      entry("NumCounts", UInt64(allCounts.count)),
+      entry("NumFunctions", UInt64(self.profileCounts.count)),
+      self.metadataNode([
+        self.metadataString("DetailedSummary"),
+        self.metadataNode(detailed),
+      ]),
+    ])
+    let key = "ProfileSummary"
+    LLVMAddModuleFlag(self.module.llvm, LLVMModuleFlagBehaviorError,
+                      key, key.utf8.count, LLVMValueAsMetadata(summary))
+  }
+
+  private func profileString(_ value: String, _ name: String) -> IRValue {
+    let bytes = ArrayType.constant(string: value, in: self.module.context)
+    var global = self.module.addGlobal(name, initializer: bytes)
+    global.linkage = .private
+    global.isGlobalConstant = true
+    return global.constGEP(indices: [
+      IntType.int32.constant(0), IntType.int32.constant(0)
+    ])
+  }
+
+  func metadataString(_ value: String) -> LLVMValueRef {
+    return LLVMMDStringInContext(self.module.context.llvm,
+                                 value, UInt32(value.utf8.count))
+  }
+
+  func metadataNode(_ operands: [LLVMValueRef?]) -> LLVMValueRef {
+    var operands = operands
+    return LLVMMDNodeInContext(self.module.context.llvm,
+                               &operands, UInt32(operands.count))
+  }
+
+  func metadataKind(_ name: String) -> UInt32 {
+    return LLVMGetMDKindIDInContext(self.module.context.llvm,
+                                    name, UInt32(name.utf8.count))
+  }
+}
+
+extension IRGenGIRFunction {
+  /// Counts or annotates entry to the function at the current insertion
+  /// point.
+  func emitProfileEntry() {
+    switch self.profile {
+    case .none:
+      return
+    case let .some(.instrumented(layout, counters)):
+      self.emitCounterIncrement(layout, counters, 0)
+    case let .some(.profiled(_, counts)):
+      let node = IGM.metadataNode([
+        IGM.metadataString("function_entry_count"),
+        IntType.int64.constant(counts[0]).asLLVM(),
+      ])
+      LLVMGlobalSetMetadata(self.function.asLLVM(), IGM.metadataKind("prof"),
+                            LLVMValueAsMetadata(node))
+    }
+  }
+
+  /// If the function is instrumented, interposes a block that counts each
+  /// destination of a `switch_constr` before branching to it.
+  func instrumentSwitch(
+    _ op: SwitchConstrOp,
+    _ dests: [(String, BasicBlock)], _ defaultDest: BasicBlock?
+  ) -> ([(String, BasicBlock)], BasicBlock?) {
+    guard
+      case let .some(.instrumented(layout, counters)) = self.profile,
+      let base = layout.switchOffsets[op]
+    else {
+      return (dests, defaultDest)
+    }
+
+    let pos = self.B.insertBlock!
+    func counted(_ index: Int, _ dest: BasicBlock) -> BasicBlock {
+      let block = self.function.appendBasicBlock(named: "prof")
+      self.B.positionAtEnd(of: block)
+      self.emitCounterIncrement(layout, counters, index)
+      self.B.buildBr(dest)
+      return block
+    }
+    let countedDests = dests.enumerated().map { (i, dest) in
+      return (dest.0, counted(base + i, dest.1))
+    }
+    let countedDefault = defaultDest.map { counted(base + dests.count, $0) }
+    self.B.positionAtEnd(of: pos)
+    return (countedDests, countedDefault)
+  }
+
+  /// If the function has a profile, attaches branch weights to the
+  /// terminator just emitted for a `switch_constr`.
+  func annotateSwitch(
+    _ op: SwitchConstrOp,
+    _ dests: [(String, BasicBlock)], _ defaultDest: BasicBlock?
+  ) {
+    guard
+      case let .some(.profiled(layout, counts)) = self.profile,
+      let base = layout.switchOffsets[op],
+      let terminator = LLVMGetBasicBlockTerminator(self.B.insertBlock!.llvm)
+    else {
+      return
+    }
+
+    // A strategy may lower the switch to a branch or a switch instruction,
+    // so weigh each successor by the destinations that lead to it.  Blocks
+    // synthesized by the strategy were never reached.
+    var weights = [LLVMBasicBlockRef: UInt64]()
+    for (i, dest) in dests.enumerated() {
+      weights[dest.1.llvm, default: 0] += counts[base + i]
+    }
+    if let defaultDest = defaultDest {
+      weights[defaultDest.llvm, default: 0] += counts[base + dests.count]
+    }
+
+    let successorCount = LLVMGetNumSuccessors(terminator)
+    guard successorCount > 1 else {
+      return
+    }
+    let successorWeights = (0..<successorCount).map { i -> UInt64 in
+      return weights[LLVMGetSuccessor(terminator, i)] ?? 0
+    }
+
+    // Branch weights are 32 bits wide; scale large counts down and keep
+    // every edge non-zero so none is treated as impossible.
+    let maxWeight = successorWeights.max() ?? 0
+    let scale = maxWeight > UInt64(UInt32.max)
+              ? maxWeight / UInt64(UInt32.max) + 1
+              : 1
+    var operands = [IGM.metadataString("branch_weights")]
+    for weight in successorWeights {
+      operands.append(IntType.int32.constant(weight / scale + 1).asLLVM())
+    }
+    LLVMSetMetadata(terminator, IGM.metadataKind("prof"),
+                    IGM.metadataNode(operands))
+  }
+
+  private func emitCounterIncrement(
+    _ layout: FunctionProfileLayout, _ counters: Global, _ index: Int
+  ) {
+    let countersTy = ArrayType(elementType: IntType.int64,
+                               count: layout.counterCount)
+    let slot = self.B.buildInBoundsGEP(counters, type: countersTy, indices: [
+      IntType.int32.constant(0),
+      IntType.int32.constant(index),
+    ])
+    let count = self.B.buildLoad(slot, type: IntType.int64, name: "pgocount")
+    let next = self.B.buildAdd(count, IntType.int64.constant(1))
+    self.B.buildStore(next, to: slot)
+  }
+}
@@ -5,6 +5,7 @@
 /// This project is released under the MIT license, a copy of which is
 /// available in the repository.
 
+import cllvm
 import LLVM
 import Seismography
 
@@ -19,6 +20,9 @@ enum RuntimeIntrinsic: String {
   /// The runtime hook for the silt alloc function.
   case alloc  = "silt_alloc"
 
+  /// Allocates like `silt_alloc` and attributes the object to a site.
+  case allocProfiled = "silt_alloc_profiled"
+
   /// The runtime hook for the silt alloc function.
   case dealloc  = "silt_dealloc"
 
@@ -28,6 +32,21 @@ enum RuntimeIntrinsic: String {
 
   case release = "silt_release"
 
+  /// Begins an invocation of a function with counted reference counting.
+  case refcountEnter = "silt_refcount_enter"
+
+  /// Counting variants of the reference counting entry points.
+  case retainProfiled = "silt_retain_profiled"
+  case releaseProfiled = "silt_release_profiled"
+  case copyValueProfiled = "silt_copyValue_profiled"
+  case destroyValueProfiled = "silt_destroyValue_profiled"
+
+  /// Registers the counters of an instrumented program.
+  case profileRegister = "silt_profile_register"
+
+  /// Writes the counters of an instrumented program to its profile.
+  case profileWrite = "silt_profile_write"
+
   /// The LLVM IR type corresponding to the definition of this function.
   var type: LLVM.FunctionType {
     switch self {
@@ -41,6 +60,13 @@ enum RuntimeIntrinsic: String {
         IntType.int64,
         IntType.int64
       ], PointerType.toVoid)
+    case .allocProfiled:
+      return LLVM.FunctionType([
+        PointerType.toVoid,
+        IntType.int64,
+        IntType.int64,
+        PointerType.toVoid
+      ], PointerType.toVoid)
     case .dealloc:
       return LLVM.FunctionType([
         PointerType.toVoid,
@@ -57,10 +83,134 @@ enum RuntimeIntrinsic: String {
       return LLVM.FunctionType([PointerType.toVoid], PointerType.toVoid)
     case .release:
       return LLVM.FunctionType([PointerType.toVoid], VoidType())
+    case .refcountEnter:
+      return LLVM.FunctionType([], IntType.int64)
+    case .retainProfiled, .copyValueProfiled:
+      return LLVM.FunctionType([
+        PointerType.toVoid,
+        PointerType.toVoid,
+        IntType.int64
+      ], PointerType.toVoid)
+    case .releaseProfiled, .destroyValueProfiled:
+      return LLVM.FunctionType([
+        PointerType.toVoid,
+        PointerType.toVoid,
+        IntType.int64
+      ], VoidType())
+    case .profileRegister:
+      return LLVM.FunctionType([
+        PointerType.toVoid,
+        IntType.int64,
+        PointerType.toVoid
+      ], VoidType())
+    case .profileWrite:
+      return LLVM.FunctionType([], VoidType())
     }
   }
 }
 
+extension RuntimeIntrinsic {
+  /// Tells LLVM what this function does, so that it can delete unused
+  /// allocations, forward stores through newly allocated objects and keep
+  /// values in registers across calls to the runtime.
+  ///
+  /// These describe the declarations IRGen emits.  When the runtime's bitcode
+  /// is linked in, its definitions replace them, and inlining their bodies
+  /// exposes `malloc` and `free` to LLVM directly.
+  ///
+  /// Attributes the linked version of LLVM does not know are skipped.
+  func addAttributes(to function: LLVMValueRef) {
+    let context = LLVMGetTypeContext(LLVMTypeOf(function))
+    func add(_ name: String, at index: LLVMAttributeIndex, _ value: UInt64) {
+      addEnumAttribute(name, to: function, at: index, value)
+    }
+    func addToFunction(_ name: String, _ value: UInt64 = 0) {
+      add(name, at: functionAttributeIndex, value)
+    }
+    func addToResult(_ name: String) {
+      add(name, at: 0, 0)
+    }
+    func addToParameter(_ index: LLVMAttributeIndex, _ name: String) {
+      add(name, at: index + 1, 0)
+    }
+    func addAllocatorFamily() {
+      let key = "alloc-family"
+      let family = "silt"
+      let attribute = LLVMCreateStringAttribute(
+        context, key, UInt32(key.utf8.count),
+        family, UInt32(family.utf8.count))
+      LLVMAddAttributeAtIndex(function, functionAttributeIndex, attribute)
+    }
+
+    // Silt code never unwinds; the runtime aborts instead.
+    addToFunction("nounwind")
+
+    switch self {
+    case .alloc:
+      addToResult("noalias")
+      addToResult("nonnull")
+      // The object's header is initialized, so it is not "uninitialized"
+      // memory as far as LLVM is concerned.
+      addToFunction("allockind", AllocKind.alloc)
+      addToFunction("allocsize", allocSize(argument: 1))
+      // N.B. No memory attribute: besides the new object, an allocation
+      // updates the heap statistics, which the runtime's bitcode exposes
+      // to the module.
+      addAllocatorFamily()
+    case .allocProfiled:
+      // Not an allocator as far as LLVM is concerned: deleting an unused
+      // allocation would hide it from the profile.
+      addToResult("noalias")
+      addToResult("nonnull")
+    case .dealloc, .deallocUninitialized:
+      addToFunction("allockind", AllocKind.free)
+      addToParameter(0, "allocptr")
+      addAllocatorFamily()
+    case .retain:
+      // A retain only touches the reference count of its argument.
+      addToParameter(0, "returned")
+      addToFunction("argmemonly")
+      addToFunction("nofree")
+      addToFunction("willreturn")
+    case .copyValue:
+      addToResult("noalias")
+      addToResult("nonnull")
+    case .destroyValue, .release, .refcountEnter, .retainProfiled,
+         .releaseProfiled, .copyValueProfiled, .destroyValueProfiled,
+         .profileRegister, .profileWrite:
+      break
+    }
+  }
+}
+
+/// Adds the named attribute to a function, its result or one of its
+/// parameters, unless the linked version of LLVM does not know it.
+func addEnumAttribute(
+  _ name: String, to function: LLVMValueRef,
+  at index: LLVMAttributeIndex = functionAttributeIndex, _ value: UInt64 = 0
+) {
+  let kind = LLVMGetEnumAttributeKindForName(name, name.utf8.count)
+  guard kind != 0 else {
+    return
+  }
+  let context = LLVMGetTypeContext(LLVMTypeOf(function))
+  let attribute = LLVMCreateEnumAttribute(context, kind, value)
+  LLVMAddAttributeAtIndex(function, index, attribute)
+}
+
+/// The bits of LLVM's `allockind` attribute.
+private enum AllocKind {
+  static let alloc: UInt64 = 1 << 0
+  static let free: UInt64 = 1 << 2
+}
+
+/// Encodes an `allocsize` attribute whose size is the given argument.
+private func allocSize(argument: UInt64) -> UInt64 {
+  // The high half is the size argument; the low half, the argument giving
+  // an element count, of which there is none.
+  return argument << 32 | UInt64(UInt32.max)
+}
+
 enum MetadataKind: Int {
   case heapLocalVariable = 1
 }
@@ -75,13 +225,22 @@ final class IRGenRuntime {
   /// Emits a raw heap allocation of a number of bytes, and gives back a
   /// non-NULL pointer.
   /// - parameter bytes: The number of bytes to allocate.
+  /// - parameter site: A description of what is being allocated, used to
+  ///                   attribute the allocation when profiling allocations.
   /// - returns: An LLVM IR value that represents a heap-allocated value that
   ///            must be freed.
   func emitAlloc(
-    _ metadata: IRValue, _ size: IRValue, _ align: IRValue
+    _ metadata: IRValue, _ size: IRValue, _ align: IRValue,
+    site: String = "object"
   ) -> IRValue {
-    let fn = emitIntrinsic(.alloc)
-    return IGF.B.buildCall(fn, args: [metadata, size, align])
+    guard IGF.IGM.instrumentation.contains(.allocations) else {
+      let fn = emitIntrinsic(.alloc)
+      return IGF.B.buildCall(fn, args: [metadata, size, align])
+    }
+    let fn = emitIntrinsic(.allocProfiled)
+    return IGF.B.buildCall(fn, args: [
+      metadata, size, align, IGF.instrumentationSite(site)
+    ])
   }
 
   /// Deallocates a heap value allocated via `silt_alloc`.
@@ -100,30 +259,39 @@ final class IRGenRuntime {
   }
 
   func emitIntrinsic(_ intrinsic: RuntimeIntrinsic) -> Function {
-    if let fn = IGF.IGM.module.function(named: intrinsic.rawValue) {
-      return fn
-    }
-    return IGF.B.addFunction(intrinsic.rawValue, type: intrinsic.type)
+    return IGF.IGM.runtimeFunction(intrinsic)
   }
 
   func emitCopyValue(_ value: IRValue, name: String = "") -> IRValue {
-    let fn = emitIntrinsic(.copyValue)
-    return IGF.B.buildCall(fn, args: [value], name: name)
+    return self.emitRefCounting(.copyValue, .copyValueProfiled,
+                                "copy_value", value, name: name)
   }
 
   func emitDestroyValue(_ value: IRValue) {
-    let fn = emitIntrinsic(.destroyValue)
-    _ = IGF.B.buildCall(fn, args: [value])
+    _ = self.emitRefCounting(.destroyValue, .destroyValueProfiled,
+                             "destroy_value", value)
   }
 
   func emitRetain(_ value: IRValue) {
-    let fn = emitIntrinsic(.retain)
-    _ = IGF.B.buildCall(fn, args: [value])
+    _ = self.emitRefCounting(.retain, .retainProfiled, "retain", value)
   }
 
   func emitRelease(_ value: IRValue) {
-    let fn = emitIntrinsic(.release)
-    _ = IGF.B.buildCall(fn, args: [value])
+    _ = self.emitRefCounting(.release, .releaseProfiled, "release", value)
+  }
+
+  /// Calls a reference counting entry point, or its counting variant if
+  /// reference counting is instrumented.
+  private func emitRefCounting(
+    _ intrinsic: RuntimeIntrinsic, _ profiled: RuntimeIntrinsic,
+    _ operation: String, _ value: IRValue, name: String = ""
+  ) -> IRValue {
+    guard IGF.IGM.instrumentation.contains(.refcounting) else {
+      return IGF.B.buildCall(emitIntrinsic(intrinsic), args: [value],
+                             name: name)
+    }
+    let args = [value] + IGF.refcountSiteArguments(operation)
+    return IGF.B.buildCall(emitIntrinsic(profiled), args: args, name: name)
   }
 }
 
@@ -249,6 +417,7 @@ struct RecordLayout {
       self.isKnownPOD = true
       self.llvmType = typeToFill ?? IGM.opaquePtrTy.pointee
     } else {
+      builder.finish()
       self.minimumAlignment = builder.alignment
       self.minimumSize = builder.size
       self.wantsFixedLayout = builder.wantsFixedLayout
@@ -286,18 +455,28 @@ struct RecordLayout {
     var alignment = Alignment(1)
     var wantsFixedLayout = true
     var isKnownPOD = true
+    var isPacked = false
     var structFields = [IRType]()
     var fieldLayouts: [FieldLayout] = []
 
+    /// The LLVM type and offset of each piece of fixed-offset storage laid
+    /// out so far.  Padding between them is only materialized by `finish`.
+    private var storage: [(type: IRType, offset: Size)] = []
+
     init(_ IGM: IRGenModule) {
       self.IGM = IGM
     }
 
     typealias AddedStorage = Bool
     func addFields(_ typeInfos: [TypeInfo]) -> AddedStorage {
-      self.fieldLayouts.reserveCapacity(typeInfos.capacity)
+      self.fieldLayouts.reserveCapacity(typeInfos.count)
 
       // Track whether we've added any storage to our layout.
+      //
+      // N.B. Fields are stored in declaration order, even where sorting them
+      // by alignment would save padding.  Tuples are structural: a tuple of
+      // fixed-size elements has the same layout as an instance of a generic
+      // tuple, whose offsets are computed at runtime in declaration order.
       var addedStorage = false
       for typeInfo in typeInfos {
         let added = self.addField(typeInfo)
@@ -354,11 +533,11 @@ struct RecordLayout {
     }
 
     func addHeapHeader() {
-      assert(self.structFields.isEmpty,
+      assert(self.storage.isEmpty,
              "adding heap header at a non-zero offset")
       self.size = IGM.dataLayout.layout(of: IGM.refCountedTy).size
       self.alignment = IGM.getPointerAlignment()
-      self.structFields.append(IGM.refCountedTy)
+      self.storage.append((IGM.refCountedTy, Size.zero))
     }
 
 
@@ -383,23 +562,7 @@ struct RecordLayout {
 
       // If the current tuple size isn't a multiple of the field's
       // required alignment, we need to pad out.
-      let eltAlignment = eltTI.alignment
-      let offsetFromAlignment = self.size % eltAlignment
-      if offsetFromAlignment != Size(0) {
-        let paddingRequired
-          = UInt64(eltAlignment.rawValue) - offsetFromAlignment.rawValue
-        assert(paddingRequired != 0)
-
-        // Regardless, the storage size goes up.
-        self.size += Size(paddingRequired)
-
-        // Add the padding to the fixed layout.
-        if self.wantsFixedLayout {
-          let paddingTy = ArrayType(elementType: IntType.int8,
-                                    count: Int(paddingRequired))
-          self.structFields.append(paddingTy)
-        }
-      }
+      self.size = self.size.roundUp(to: eltTI.alignment)
 
       // If the overall structure so far has a fixed layout, then add
       // this as a field to the layout.
@@ -414,11 +577,12 @@ struct RecordLayout {
 
     func addElementAtFixedOffset(_ eltTI: FixedTypeInfo) {
       assert(self.wantsFixedLayout)
+      // Until the layout is finished, the index is that of the storage.
       self.fieldLayouts.append(FieldLayout(kind: .fixed,
-                                           index: structFields.count,
+                                           index: self.storage.count,
                                            type: eltTI, isPOD: eltTI.isPOD,
                                            byteOffset: self.size))
-      self.structFields.append(eltTI.llvmType)
+      self.storage.append((eltTI.llvmType, self.size))
     }
 
     func addElementAtNonFixedOffset(_ elt: TypeInfo) {
@@ -433,16 +597,96 @@ struct RecordLayout {
       return self.wantsFixedLayout && self.size == .zero
     }
 
+    /// Completes the layout of a record with storage.
+    ///
+    /// The size of a fixed layout is not rounded up to its alignment: like
+    /// the runtime, which places the element after a record at the record's
+    /// offset plus its size, a record's tail padding is left to be reused.
+    /// Only its stride is rounded.
+    ///
+    /// The record is emitted as an ordinary struct when LLVM would place
+    /// every piece of storage at the offset chosen for it, and leaves LLVM
+    /// to insert the padding.  Otherwise, as when a more aligned field
+    /// leaves tail padding LLVM would count in the struct's size, the struct
+    /// is packed and padded explicitly.
+    func finish() {
+      let indices: [Int]
+      if let natural = self.lowerStorage(isPacked: false) {
+        (self.structFields, indices) = natural
+      } else {
+        // A packed struct can realize any layout.
+        (self.structFields, indices) = self.lowerStorage(isPacked: true)!
+        self.isPacked = true
+      }
+      self.fieldLayouts = self.fieldLayouts.map { layout in
+        guard layout.kind == .fixed else {
+          return layout
+        }
+        return FieldLayout(kind: .fixed, index: indices[layout.index],
+                           type: layout.typeInfo, isPOD: layout.isPOD,
+                           byteOffset: layout.byteOffset)
+      }
+    }
+
+    /// Computes the element types of a struct that places each piece of
+    /// storage at its offset, and the element index of each piece, or
+    /// returns `nil` if a struct that is or isn't packed cannot.
+    private func lowerStorage(
+      isPacked: Bool
+    ) -> (fields: [IRType], indices: [Int])? {
+      var fields = [IRType]()
+      var indices = [Int]()
+      var end = Size.zero
+      var structAlignment = Alignment.one
+      func pad(to offset: Size) {
+        fields.append(ArrayType(elementType: IntType.int8,
+                                count: Int((offset - end).rawValue)))
+      }
+
+      for (type, offset) in self.storage {
+        let typeAlignment = isPacked
+                          ? Alignment.one
+                          : self.IGM.dataLayout.abiAlignment(of: type)
+        structAlignment = max(structAlignment, typeAlignment)
+        guard end <= offset, offset % typeAlignment == .zero else {
+          return nil
+        }
+        if end.roundUp(to: typeAlignment) != offset {
+          pad(to: offset)
+        }
+        indices.append(fields.count)
+        fields.append(type)
+        end = offset + Size(self.IGM.dataLayout.allocationSize(of: type))
+      }
+
+      // Only a fixed layout's storage covers its size.
+      guard self.wantsFixedLayout else {
+        return (fields, indices)
+      }
+      guard end <= self.size else {
+        return nil
+      }
+      if end.roundUp(to: structAlignment) != self.size {
+        pad(to: self.size)
+        end = self.size
+      }
+      guard end.roundUp(to: structAlignment) == self.size else {
+        return nil
+      }
+      return (fields, indices)
+    }
+
     func setAsBodyOfStruct(_ type: StructType) {
       assert(type.isOpaque)
-      type.setBody(self.structFields, isPacked: true)
+      type.setBody(self.structFields, isPacked: self.isPacked)
       assert(!self.wantsFixedLayout
         || IGM.dataLayout.layout(of: type).size == self.size,
              "LLVM size of fixed struct type does not match StructLayout size")
     }
 
     func asAnonymousStruct() -> StructType {
-      let ty = StructType(elementTypes: self.structFields, isPacked: true,
+      let ty = StructType(elementTypes: self.structFields,
+                          isPacked: self.isPacked,
                           in: self.IGM.module.context)
       assert(!self.wantsFixedLayout
         || self.IGM.dataLayout.layout(of: ty).size == self.size,
@@ -460,25 +704,26 @@ extension RecordLayout {
     let dtorFn = self.createDtorFn(IGM, self)
     let kindIdx = MetadataKind.heapLocalVariable.rawValue
 
-    // Build the fields of the private metadata.
-    let fty = FunctionType([
-      PointerType.toVoid
-    ], VoidType())
+    // Build the fields of the private metadata.  Pointers to other
+    // constants are relative so the record needs no load-time relocations
+    // and can be placed in read-only memory; Ferrite's
+    // HeapLocalVariableMetadata reads them back.
     let type = StructType(elementTypes: [
-      PointerType(pointee: fty),
-      PointerType(pointee: PointerType.toVoid),
+      IntType.int32,                      // destroy
+      IntType.int32,                      // value witnesses
       StructType(elementTypes: [
         IGM.dataLayout.intPointerType()
       ], isPacked: false, in: IGM.module.context),
-      IntType.int32,
-      PointerType.toVoid,
+      IntType.int32,                      // offset to first field
+      IntType.int32,                      // capture descriptor
     ], isPacked: false, in: IGM.module.context)
 
     let variable = ConstantBuilder.buildInitializerForStruct(
       in: IGM.module, type: type, named: "metadata",
       alignment: IGM.getPointerAlignment(), linkage: .private) { fields in
-      fields.add(dtorFn)
-      fields.addNullPointer(PointerType(pointee: PointerType.toVoid))
+      fields.addRelativeAddress(to: dtorFn)
+      // Boxes don't have value witnesses yet.
+      fields.addInt32(0)
 
       fields.beginSubStructure(structTy: StructType(elementTypes: [
         IGM.dataLayout.intPointerType()
@@ -496,7 +741,7 @@ extension RecordLayout {
       }
       fields.addInt32(UInt32(offset.rawValue))
 
-      fields.add(captureDescriptor)
+      fields.addRelativeAddressOrNull(to: captureDescriptor)
     }
 
     return variable.constGEP(indices: [
@@ -681,3 +926,15 @@ private func initialOffset(
     return IGF.B.buildAdd(offset, IGF.GR.emitLoadOfSize(prevType))
   }
 }
+
+extension IRGenModule {
+  /// Declares a runtime entry point outside of any function.
+  func runtimeFunction(_ intrinsic: RuntimeIntrinsic) -> Function {
+    if let fn = self.module.function(named: intrinsic.rawValue) {
+      return fn
+    }
+    let fn = self.B.addFunction(intrinsic.rawValue, type: intrinsic.type)
+    intrinsic.addAttributes(to: fn.asLLVM())
+    return fn
+  }
+}
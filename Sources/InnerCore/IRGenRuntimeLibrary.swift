@@ -0,0 +1,113 @@
+/// IRGenRuntimeLibrary.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import cllvm
+import LLVM
+
+/// An error raised while linking the Ferrite bitcode library into a module.
+public enum RuntimeLibraryError: Error, CustomStringConvertible {
+  /// The bitcode file could not be read.
+  case couldNotRead(String, String)
+  /// The file was read but did not contain a valid bitcode module.
+  case invalidBitcode(String)
+  /// The LLVM linker rejected the module.
+  case linkFailed(String)
+
+  public var description: String {
+    switch self {
+    case let .couldNotRead(path, message):
+      return "could not read runtime bitcode at '\(path)': \(message)"
+    case let .invalidBitcode(path):
+      return "'\(path)' is not a valid runtime bitcode file"
+    case let .linkFailed(path):
+      return "could not link runtime bitcode at '\(path)'"
+    }
+  }
+}
+
+extension IRGen {
+  /// Links the Ferrite bitcode library into a module emitted by `IRGen.emit`
+  /// so that LLVM can inline the runtime's fast paths into generated code.
+  ///
+  /// Every definition the library contributes is given `available_externally`
+  /// linkage: its body is visible to the optimizer, but no code is emitted
+  /// for it, and any call that is not inlined still binds to the native
+  /// Ferrite library at link time.  This must run before the LLVM
+  /// optimization pipeline, which is where the bodies are consumed.
+  ///
+  /// - Parameters:
+  ///   - module: The module to link the runtime into.
+  ///   - path: The path to the bitcode built by `utils/build-ferrite-bitcode`.
+  public static func linkRuntime(
+    into module: Module, bitcodeAt path: String
+  ) throws {
+    var buffer: LLVMMemoryBufferRef?
+    var message: UnsafeMutablePointer<Int8>?
+    guard
+      LLVMCreateMemoryBufferWithContentsOfFile(path, &buffer, &message) == 0
+    else {
+      let reason = message.map { String(cString: $0) } ?? "unknown error"
+      LLVMDisposeMessage(message)
+      throw RuntimeLibraryError.couldNotRead(path, reason)
+    }
+    defer { LLVMDisposeMemoryBuffer(buffer) }
+
+    var runtime: LLVMModuleRef?
+    guard
+      LLVMParseBitcodeInContext2(module.context.llvm, buffer, &runtime) == 0,
+      let runtimeModule = runtime
+    else {
+      throw RuntimeLibraryError.invalidBitcode(path)
+    }
+
+    // Remember what the module defined on its own so only the runtime's
+    // contributions are demoted after linking.
+    let ownDefinitions =
+      Set(self.externalDefinitions(in: module.llvm).map { $0.name })
+
+    // N.B. This consumes the runtime module.
+    guard LLVMLinkModules2(module.llvm, runtimeModule) == 0 else {
+      throw RuntimeLibraryError.linkFailed(path)
+    }
+
+    for value in self.externalDefinitions(in: module.llvm)
+      where !ownDefinitions.contains(value.name) {
+      LLVMSetLinkage(value.ref, LLVMAvailableExternallyLinkage)
+    }
+  }
+
+  /// Collects the functions and global variables with bodies or
+  /// initializers and external linkage.
+  private static func externalDefinitions(
+    in module: LLVMModuleRef
+  ) -> [(name: String, ref: LLVMValueRef)] {
+    var result = [(name: String, ref: LLVMValueRef)]()
+    func visit(_ value: LLVMValueRef) {
+      guard LLVMIsDeclaration(value) == 0,
+            LLVMGetLinkage(value) == LLVMExternalLinkage else {
+        return
+      }
+      var length = 0
+      guard let name = LLVMGetValueName2(value, &length) else {
+        return
+      }
+      result.append((String(cString: name), value))
+    }
+
+    var function = LLVMGetFirstFunction(module)
+    while let fn = function {
+      visit(fn)
+      function = LLVMGetNextFunction(fn)
+    }
+    var global = LLVMGetFirstGlobal(module)
+    while let gv = global {
+      visit(gv)
+      global = LLVMGetNextGlobal(gv)
+    }
+    return result
+  }
+}
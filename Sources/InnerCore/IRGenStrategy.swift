@@ -366,7 +366,7 @@ final class SingleBitDataTypeStrategy: NoPayloadStrategy {
 
   func initialize(_ IGF: IRGenFunction, _ from: Explosion, _ addr: Address) {
     let addr = IGF.B.createStructGEP(addr, 0, .zero, "")
-    IGF.B.buildStore(from.claimSingle(), to: addr.address)
+    IGF.emitStore(from.claimSingle(), to: addr)
   }
 
   func copy(_ IGF: IRGenFunction, _ src: Explosion, _ dest: Explosion) {
@@ -380,13 +380,13 @@ final class SingleBitDataTypeStrategy: NoPayloadStrategy {
   func loadAsCopy(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
     let addr = IGF.B.createStructGEP(addr, 0, .zero, "")
-    explosion.append(IGF.B.createLoad(addr))
+    explosion.append(IGF.emitLoad(addr))
   }
 
   func loadAsTake(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
     let addr = IGF.B.createStructGEP(addr, 0, .zero, "")
-    explosion.append(IGF.B.createLoad(addr))
+    explosion.append(IGF.emitLoad(addr))
   }
 
   func emitDataProjection(_ IGF: IRGenFunction, _ : String,
@@ -413,7 +413,7 @@ final class SingleBitDataTypeStrategy: NoPayloadStrategy {
 
   func assign(_ IGF: IRGenFunction, _ src: Explosion, _ dest: Address) {
     let newValue = src.claimSingle()
-    IGF.B.buildStore(newValue, to: dest.address)
+    IGF.emitStore(newValue, to: dest)
   }
 
   func assignWithCopy(_ IGF: IRGenFunction,
@@ -469,17 +469,17 @@ final class NoPayloadDataTypeStrategy: NoPayloadStrategy {
   }
 
   func initialize(_ IGF: IRGenFunction, _ src: Explosion, _ addr: Address) {
-    IGF.B.buildStore(src.claimSingle(), to: addr.address)
+    IGF.emitStore(src.claimSingle(), to: addr)
   }
 
   func loadAsTake(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
-    explosion.append(IGF.B.createLoad(addr))
+    explosion.append(IGF.emitLoad(addr))
   }
 
   func loadAsCopy(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
-    let value = IGF.B.createLoad(addr)
+    let value = IGF.emitLoad(addr)
     self.emitScalarRelease(IGF, value)
     explosion.append(value)
   }
@@ -513,8 +513,8 @@ final class NoPayloadDataTypeStrategy: NoPayloadStrategy {
   func assignWithCopy(_ IGF: IRGenFunction,
                       _ dest: Address, _ source: Address, _ : GIRType) {
     let addr = IGF.B.createStructGEP(source, 0, .zero, "")
-    let value = IGF.B.createLoad(addr)
-    IGF.B.buildStore(value, to: dest.address)
+    let value = IGF.emitLoad(addr)
+    IGF.emitStore(value, to: dest)
   }
 }
 
@@ -647,7 +647,7 @@ final class SinglePayloadDataTypeStrategy: PayloadStrategy {
   func destroy(_ IGF: IRGenFunction, _ addr: Address, _ type: GIRType) {
     let ptrTy = PointerType(pointee: IGF.IGM.refCountedPtrTy)
     let addr = IGF.B.createPointerBitCast(of: addr, to: ptrTy)
-    let ptr = IGF.B.createLoad(addr)
+    let ptr = IGF.emitLoad(addr)
     IGF.GR.emitRelease(ptr)
   }
 
@@ -804,17 +804,17 @@ final class NaturalDataTypeStrategy: NoPayloadStrategy {
   }
 
   func initialize(_ IGF: IRGenFunction, _ src: Explosion, _ addr: Address) {
-    IGF.B.buildStore(src.claimSingle(), to: addr.address)
+    IGF.emitStore(src.claimSingle(), to: addr)
   }
 
   func loadAsTake(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
-    explosion.append(IGF.B.createLoad(addr))
+    explosion.append(IGF.emitLoad(addr))
   }
 
   func loadAsCopy(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
-    explosion.append(IGF.B.createLoad(addr))
+    explosion.append(IGF.emitLoad(addr))
   }
 
   func copy(_ IGF: IRGenFunction, _ src: Explosion, _ dest: Explosion) {
@@ -838,7 +838,7 @@ final class NaturalDataTypeStrategy: NoPayloadStrategy {
 
   func assign(_ IGF: IRGenFunction, _ src: Explosion, _ dest: Address) {
     let newValue = src.claimSingle()
-    IGF.B.buildStore(newValue, to: dest.address)
+    IGF.emitStore(newValue, to: dest)
   }
 
   func assignWithCopy(_ IGF: IRGenFunction, _ dest: Address,
@@ -0,0 +1,134 @@
+/// IRGenTBAA.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import cllvm
+import LLVM
+
+/// The kinds of memory IRGen distinguishes for LLVM's type-based alias
+/// analysis.  Accesses of two kinds may only alias if one kind contains the
+/// other:
+///
+///     silt
+///     ├── silt.metadata     type metadata, which is never written
+///     └── silt.value        the storage of any Silt value
+///         ├── silt.pointer  heap objects, functions and environments
+///         └── silt.iN       integers of each width
+///
+/// An access to storage whose contents may be reinterpreted, such as the
+/// payload of a data value, uses `silt.value` itself so it aliases every
+/// access to a value.
+enum AliasClass: Hashable {
+  /// Type metadata records.
+  case metadata
+  /// Storage that may hold a value of any type.
+  case value
+  /// A pointer to a heap object, function or environment.
+  case pointer
+  /// An integer of the given width in bits.
+  case integer(Int)
+
+  /// Classifies an access of the given type to the storage of a value.
+  ///
+  /// Aggregates are accessed as a whole by some paths and field by field by
+  /// others, so they may alias anything a value holds.
+  init(accessing type: IRType) {
+    switch type {
+    case is PointerType:
+      self = .pointer
+    case let type as IntType:
+      self = .integer(type.width)
+    default:
+      self = .value
+    }
+  }
+
+  fileprivate var name: String {
+    switch self {
+    case .metadata: return "silt.metadata"
+    case .value: return "silt.value"
+    case .pointer: return "silt.pointer"
+    case let .integer(width): return "silt.i\(width)"
+    }
+  }
+
+  fileprivate var parent: AliasClass? {
+    switch self {
+    case .metadata, .value: return nil
+    case .pointer, .integer(_): return .value
+    }
+  }
+}
+
+extension IRGenModule {
+  /// The access tag LLVM attaches to loads and stores of the given class.
+  func tbaaTag(_ aliasClass: AliasClass) -> LLVMValueRef {
+    if let tag = self.tbaaTags[aliasClass] {
+      return tag
+    }
+    let type = self.tbaaTypeNode(aliasClass)
+    let tag = self.metadataNode([
+      type, type, IntType.int64.constant(0).asLLVM(),
+    ])
+    self.tbaaTags[aliasClass] = tag
+    return tag
+  }
+
+  private func tbaaTypeNode(_ aliasClass: AliasClass) -> LLVMValueRef {
+    let parent: LLVMValueRef
+    if let parentClass = aliasClass.parent {
+      parent = self.tbaaTypeNode(parentClass)
+    } else {
+      parent = self.metadataNode([self.metadataString("silt")])
+    }
+    // Metadata nodes are uniqued, so rebuilding a type node yields the same
+    // node.
+    return self.metadataNode([
+      self.metadataString(aliasClass.name),
+      parent,
+      IntType.int64.constant(0).asLLVM(),
+    ])
+  }
+}
+
+extension IRGenFunction {
+  /// Loads the value stored at an address, telling LLVM what kind of value
+  /// it is.
+  func emitLoad(
+    _ addr: Address, alignment: Alignment = .zero, name: String = "",
+    as aliasClass: AliasClass? = nil
+  ) -> IRValue {
+    let value = self.B.createLoad(addr, alignment: alignment, name: name)
+    let tag = aliasClass ?? AliasClass(accessing: addr.pointeeType)
+    LLVMSetMetadata(value.asLLVM(), IGM.metadataKind("tbaa"), IGM.tbaaTag(tag))
+    return value
+  }
+
+  /// Stores a value to an address, telling LLVM what kind of value it is.
+  func emitStore(
+    _ value: IRValue, to addr: Address, alignment: Alignment = .zero,
+    as aliasClass: AliasClass? = nil
+  ) {
+    let store = self.B.buildStore(value, to: addr.address,
+                                  alignment: alignment)
+    let tag = aliasClass ?? AliasClass(accessing: value.type)
+    LLVMSetMetadata(store.asLLVM(), IGM.metadataKind("tbaa"), IGM.tbaaTag(tag))
+  }
+
+  /// Loads from a type metadata record.  Metadata never changes once it has
+  /// been created, so LLVM may also reuse the load wherever it likes.
+  func emitMetadataLoad(
+    _ address: IRValue, type: IRType, alignment: Alignment, name: String
+  ) -> IRValue {
+    let value = self.B.buildLoad(address, type: type,
+                                 alignment: alignment, name: name)
+    LLVMSetMetadata(value.asLLVM(), IGM.metadataKind("tbaa"),
+                    IGM.tbaaTag(.metadata))
+    LLVMSetMetadata(value.asLLVM(), IGM.metadataKind("invariant.load"),
+                    IGM.metadataNode([]))
+    return value
+  }
+}
@@ -257,10 +257,10 @@ final class NonFixedTupleTypeInfo: TupleTypeInfo, WitnessSizedTypeInfo {
           IGF.IGM.getSize(Size(index)), //     [index]
           IntType.int32.constant(1),    //       .Offset
         ])
-        return IGF.B.buildLoad(slot,
-                               type: IGF.IGM.tupleTypeMetadataTy,
-                               alignment: IGF.IGM.getPointerAlignment(),
-                               name: metadata.name + ".\(index).offset")
+        return IGF.emitMetadataLoad(slot,
+                                    type: IGF.IGM.tupleTypeMetadataTy,
+                                    alignment: IGF.IGM.getPointerAlignment(),
+                                    name: metadata.name + ".\(index).offset")
       }
     }
     return TupleNonFixedOffsets(type: T)
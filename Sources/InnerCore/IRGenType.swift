@@ -46,7 +46,7 @@ final class TypeConverter {
 
     let ti = self.getCompleteTypeInfo(T)
     let conv = NativeConvention(self.IGM, ti, true)
-    self.cache.paramConventionCache[T] = conv
+    self.cache.returnConventionCache[T] = conv
     return conv
   }
 
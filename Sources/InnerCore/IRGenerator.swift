@@ -6,12 +6,35 @@
 /// available in the repository.
 
 import LLVM
+import Lithosphere
 import OuterCore
 import Seismography
 
 public enum IRGen {
-  public static func emit(_ module: GIRModule) -> Module {
-    let igm = IRGenModule(module: module)
+  /// Lowers a GraphIR module to LLVM IR.
+  ///
+  /// - Parameters:
+  ///   - module: The module to lower.
+  ///   - targetMachine: The machine the module will be compiled for.  If
+  ///                    provided, the module takes on its triple and data
+  ///                    layout.
+  ///   - profile: Whether to instrument the module or apply a profile to it.
+  ///   - instrumentation: The runtime operations to attribute to the sites
+  ///                      that perform them.
+  ///   - sourceLocations: Locates instrumented functions in the source file.
+  ///   - statistics: Records the hit rates of IRGen's caches.
+  public static func emit(
+    _ module: GIRModule, targetMachine: TargetMachine? = nil,
+    profile: ProfileMode = .none,
+    instrumentation: IRGenInstrumentation = [],
+    sourceLocations: SourceLocationConverter? = nil,
+    statistics: IRGenStatistics = IRGenStatistics()
+  ) -> Module {
+    let igm = IRGenModule(module: module, targetMachine: targetMachine,
+                          profileMode: profile,
+                          instrumentation: instrumentation,
+                          sourceLocations: sourceLocations,
+                          statistics: statistics)
     igm.emit()
     igm.emitMain()
     return igm.module
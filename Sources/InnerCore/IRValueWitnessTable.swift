@@ -8,23 +8,71 @@
 import LLVM
 import Seismography
 
-enum ValueWitnessFunction {
+/// The operations in a value witness table, by index.  This layout must
+/// match `ValueWitnessTable` in the Ferrite headers.
+enum ValueWitnessFunction: Int {
   case destroy
+  case initializeWithCopy
+  case assignWithCopy
+  case initializeWithTake
+  case assignWithTake
+
+  /// Whether the witness takes a source object as well as a destination.
+  var hasSource: Bool {
+    return self != .destroy
+  }
+
+  /// The suffix that distinguishes an outlined witness from the other
+  /// witnesses of its type.
+  var mangledSuffix: String {
+    switch self {
+    case .destroy: return "wxx"
+    case .initializeWithCopy: return "wcp"
+    case .assignWithCopy: return "wca"
+    case .initializeWithTake: return "wtk"
+    case .assignWithTake: return "wta"
+    }
+  }
+
+  func signature(_ IGM: IRGenModule) -> LLVM.FunctionType {
+    if self.hasSource {
+      return LLVM.FunctionType([
+        IGM.opaquePtrTy, IGM.opaquePtrTy, IGM.typeMetadataPtrTy,
+      ], VoidType())
+    }
+    return LLVM.FunctionType([
+      IGM.opaquePtrTy, IGM.typeMetadataPtrTy,
+    ], VoidType())
+  }
 }
 
-enum ValueWitnessValue {
-  case size
+/// The layout values in a value witness table, by index.  Each is a
+/// pointer-sized integer.
+enum ValueWitnessValue: Int {
+  case size = 5
+  case alignmentMask
+  case stride
 }
 
 extension IRGenRuntime {
-  func emitValueWitnessFunctionRef(
-    _ type: GIRType, _ vwf: ValueWitnessFunction) -> (LLVM.Function, IRValue) {
-    fatalError()
-  }
-
+  /// Produces a layout value of a type with a fixed layout as a constant.
+  ///
+  /// FIXME: IRGen does not yet emit type metadata or value witness tables,
+  /// so the layout of other types cannot be found at runtime.
   func emitValueWitnessValue(
     _ type: GIRType, _ index: ValueWitnessValue) -> IRValue {
-    fatalError()
+    let IGM = self.IGF.IGM
+    guard let fixedTI = self.IGF.getTypeInfo(type) as? FixedTypeInfo else {
+      fatalError("cannot compute the layout of non-fixed type \(type)")
+    }
+    switch index {
+    case .size:
+      return IGM.getSize(fixedTI.fixedSize)
+    case .alignmentMask:
+      return IGM.getSize(Size(fixedTI.fixedAlignment.rawValue - 1))
+    case .stride:
+      return IGM.getSize(fixedTI.fixedSize.roundUp(to: fixedTI.fixedAlignment))
+    }
   }
 }
 
@@ -34,33 +82,176 @@ extension IRGenRuntime {
   }
 
   func emitUnmanagedAlloc(
-    _ layout: RecordLayout, _ captureDescriptor: IRConstant
+    _ layout: RecordLayout, _ captureDescriptor: IRConstant,
+    site: String = "object"
   ) -> IRValue {
     let metadata = layout.getPrivateMetadata(IGF.IGM, captureDescriptor)
     let size = layout.emitSize(IGF.IGM)
     let alignMask = layout.emitAlignMask(IGF.IGM)
 
-    return self.emitAlloc(metadata, size, alignMask)
+    return self.emitAlloc(metadata, size, alignMask, site: site)
   }
 
   func emitDestroyCall(_ T: GIRType, _ object: Address) {
     guard !T.type.isTrivial(self.IGF.IGM.girModule) else {
       return
     }
+    self.emitValueWitnessCall(.destroy, T, object, nil)
+  }
 
-    let (fn, metadata) = self.emitValueWitnessFunctionRef(T, .destroy)
-    let ptrTy = self.IGF.IGM.opaquePtrTy
-    let objectPtr = self.IGF.B.createPointerBitCast(of: object, to: ptrTy)
-    _ = self.IGF.B.buildCall(fn, args: [objectPtr.address, metadata])
+  func emitInitializeWithCopyCall(_ T: GIRType,
+                                  _ destObject: Address, _ srcObject: Address) {
+    self.emitValueWitnessCall(.initializeWithCopy, T, destObject, srcObject)
   }
 
   func emitAssignWithCopyCall(_ T: GIRType,
                               _ destObject: Address, _ srcObject: Address) {
-    fatalError("Unimplemented")
+    self.emitValueWitnessCall(.assignWithCopy, T, destObject, srcObject)
+  }
+
+  func emitInitializeWithTakeCall(_ T: GIRType,
+                                  _ destObject: Address, _ srcObject: Address) {
+    self.emitValueWitnessCall(.initializeWithTake, T, destObject, srcObject)
   }
 
   func emitAssignWithTakeCall(_ T: GIRType,
                               _ destObject: Address, _ srcObject: Address) {
-    fatalError("Unimplemented")
+    self.emitValueWitnessCall(.assignWithTake, T, destObject, srcObject)
+  }
+
+  /// Calls a value witness of a type.
+  ///
+  /// Only types whose layout IRGen knows are supported: they call a witness
+  /// outlined into this module, which LLVM is free to inline.
+  ///
+  /// FIXME: Types without a fixed layout, such as archetypes in generic
+  /// code, need the witness table of their metadata.  That needs type
+  /// metadata to be passed to generic functions first; today a `Type`
+  /// parameter lowers to nothing.
+  private func emitValueWitnessCall(
+    _ vwf: ValueWitnessFunction, _ T: GIRType,
+    _ dest: Address, _ src: Address?
+  ) {
+    let IGM = self.IGF.IGM
+    guard let fn = IGM.outlinedValueWitness(vwf, for: T) else {
+      fatalError("cannot call value witness '\(vwf)' of non-fixed type \(T)")
+    }
+    let metadata = IGM.typeMetadataPtrTy.constPointerNull()
+
+    var args = [self.IGF.B.buildBitCast(dest.address, type: IGM.opaquePtrTy)]
+    if let src = src {
+      args.append(self.IGF.B.buildBitCast(src.address, type: IGM.opaquePtrTy))
+    }
+    args.append(metadata)
+    var call = self.IGF.B.buildCall(fn, args: args)
+    call.callingConvention = CallingConvention.c
+  }
+}
+
+extension IRGenModule {
+  /// Returns the witness of a type outlined into this module, emitting it
+  /// on first use, or `nil` if IRGen can't open-code the witness.
+  ///
+  /// Outlined witnesses are emitted once per type and shared by every call
+  /// site, so copies and destroys of large values don't bloat the code
+  /// around them.  They ignore their metadata argument.
+  func outlinedValueWitness(
+    _ vwf: ValueWitnessFunction, for type: GIRType
+  ) -> Function? {
+    let typeInfo = self.getTypeInfo(type)
+    switch typeInfo {
+    case is LoadableTypeInfo:
+      break
+    case is FixedTupleTypeInfo where type is TupleType:
+      break
+    default:
+      return nil
+    }
+
+    let name = self.mangledName(of: type) + vwf.mangledSuffix
+    if let fn = self.module.function(named: name) {
+      return fn
+    }
+    let fty = vwf.signature(self)
+    var fn = self.B.addFunction(name, type: fty)
+    fn.linkage = .linkOnceODR
+    fn.visibility = .hidden
+    fn.callingConvention = .c
+    addEnumAttribute("nounwind", to: fn.asLLVM())
+
+    let IGF = IRGenFunction(self, fn, fty)
+    let ptrTy = PointerType(pointee: typeInfo.llvmType)
+    func object(_ index: Int) -> Address {
+      let param = IGF.B.buildBitCast(fn.parameter(at: index)!, type: ptrTy)
+      return typeInfo.address(for: param)
+    }
+    let dest = object(0)
+    let src = vwf.hasSource ? object(1) : nil
+    IGF.emitValueWitnessBody(vwf, type, typeInfo, dest, src)
+    IGF.B.buildRetVoid()
+    return fn
+  }
+}
+
+extension IRGenFunction {
+  /// Open-codes a value witness for a type with a known layout.
+  fileprivate func emitValueWitnessBody(
+    _ vwf: ValueWitnessFunction, _ type: GIRType, _ typeInfo: TypeInfo,
+    _ dest: Address, _ src: Address?
+  ) {
+    if let loadableTI = typeInfo as? LoadableTypeInfo {
+      let value = Explosion()
+      switch vwf {
+      case .destroy:
+        loadableTI.loadAsTake(self, dest, value)
+        loadableTI.consume(self, value)
+      case .initializeWithCopy:
+        loadableTI.loadAsCopy(self, src!, value)
+        loadableTI.initialize(self, value, dest)
+      case .assignWithCopy:
+        loadableTI.loadAsCopy(self, src!, value)
+        loadableTI.assign(self, value, dest)
+      case .initializeWithTake:
+        loadableTI.loadAsTake(self, src!, value)
+        loadableTI.initialize(self, value, dest)
+      case .assignWithTake:
+        loadableTI.loadAsTake(self, src!, value)
+        loadableTI.assign(self, value, dest)
+      }
+      return
+    }
+
+    // A tuple of fixed-size values: apply the witness to each element.
+    guard
+      let tupleTI = typeInfo as? FixedTupleTypeInfo,
+      let tupleTy = type as? TupleType
+    else {
+      fatalError("cannot open-code value witnesses for \(type)")
+    }
+    for (field, elementType) in zip(tupleTI.fields, tupleTy.elements) {
+      guard !field.isEmpty, !(vwf == .destroy && field.isPOD) else {
+        continue
+      }
+      let destField = field.projectAddress(self, dest)
+      let srcField = src.map { field.projectAddress(self, $0) }
+      let fieldTI = field.layout.typeInfo
+      if fieldTI is LoadableTypeInfo {
+        self.emitValueWitnessBody(vwf, elementType, fieldTI,
+                                  destField, srcField)
+        continue
+      }
+      switch vwf {
+      case .destroy:
+        self.GR.emitDestroyCall(elementType, destField)
+      case .initializeWithCopy:
+        self.GR.emitInitializeWithCopyCall(elementType, destField, srcField!)
+      case .assignWithCopy:
+        self.GR.emitAssignWithCopyCall(elementType, destField, srcField!)
+      case .initializeWithTake:
+        self.GR.emitInitializeWithTakeCall(elementType, destField, srcField!)
+      case .assignWithTake:
+        self.GR.emitAssignWithTakeCall(elementType, destField, srcField!)
+      }
+    }
   }
 }
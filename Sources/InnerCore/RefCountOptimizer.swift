@@ -0,0 +1,462 @@
+/// RefCountOptimizer.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import cllvm
+import LLVM
+
+/// Removes redundant calls to the runtime's reference counting entry points
+/// from LLVM IR.
+///
+/// IRGen retains and releases values conservatively, and inlining places the
+/// retains of a callee next to the releases of its caller.  LLVM cannot
+/// remove these calls because it does not know what they do, so this pass
+/// does it instead:
+///
+/// - A `silt_retain` followed by a `silt_release` of the same object cancel
+///   out if nothing in between could release the object.  So do a release
+///   and a later retain of the same object, since retaining an object that
+///   was just freed would have been an error anyway.  Pairs are matched
+///   across straight-line chains of blocks.
+/// - A release at the end of a block that branches to several blocks is
+///   sunk into each of them when one of them retains the object again, so
+///   the release and retain cancel out on that path.
+/// - A `silt_copyValue` whose only use is a `silt_destroyValue` is dead.
+/// - A loop consisting of a single block that retains and releases the same
+///   loop-invariant object once per iteration instead retains it once before
+///   the loop and releases it once after.
+///
+/// Only the plain entry points are optimized; the counting variants used by
+/// `--profile-refcounts` are left alone so the profile reflects the program.
+struct RefCountOptimizer {
+  private enum Operation {
+    case retain
+    case release
+    case copyValue
+    case destroyValue
+  }
+
+  private let module: LLVMModuleRef
+  private var operations = [LLVMValueRef: Operation]()
+  /// Runtime functions that cannot release an object.
+  private var harmless = Set<LLVMValueRef>()
+  private let readNoneKind = LLVMGetEnumAttributeKindForName("readnone", 8)
+  private let readOnlyKind = LLVMGetEnumAttributeKindForName("readonly", 8)
+
+  init(module: Module) {
+    self.module = module.llvm
+    let entryPoints: [(RuntimeIntrinsic, Operation)] = [
+      (.retain, .retain),
+      (.release, .release),
+      (.copyValue, .copyValue),
+      (.destroyValue, .destroyValue),
+    ]
+    for (intrinsic, operation) in entryPoints {
+      if let fn = LLVMGetNamedFunction(self.module, intrinsic.rawValue) {
+        self.operations[fn] = operation
+      }
+    }
+    for intrinsic in [RuntimeIntrinsic.retain, .alloc] {
+      if let fn = LLVMGetNamedFunction(self.module, intrinsic.rawValue) {
+        self.harmless.insert(fn)
+      }
+    }
+  }
+
+  /// Optimizes every function in the module.
+  func run() {
+    guard !self.operations.isEmpty else {
+      return
+    }
+    let builder = LLVMCreateBuilderInContext(LLVMGetModuleContext(module))
+    defer { LLVMDisposeBuilder(builder) }
+    var function = LLVMGetFirstFunction(self.module)
+    while let fn = function {
+      if LLVMCountBasicBlocks(fn) > 0 {
+        self.removeDeadCopies(in: fn)
+        self.hoistLoopInvariantPairs(in: fn, builder!)
+        self.sinkReleases(in: fn, builder!)
+        self.removePairs(in: fn)
+      }
+      function = LLVMGetNextFunction(fn)
+    }
+  }
+
+  private func operation(of inst: LLVMValueRef) -> Operation? {
+    guard LLVMIsACallInst(inst) != nil,
+          let callee = LLVMGetCalledValue(inst) else {
+      return nil
+    }
+    return self.operations[callee]
+  }
+
+  /// The object a reference counting call operates on, looking through
+  /// pointer casts and retains, which return their argument.
+  private func object(of call: LLVMValueRef) -> LLVMValueRef {
+    var value = LLVMGetOperand(call, 0)!
+    while true {
+      if LLVMIsABitCastInst(value) != nil
+          || self.operation(of: value) == .retain {
+        value = LLVMGetOperand(value, 0)
+      } else if LLVMIsAConstantExpr(value) != nil,
+                LLVMGetConstOpcode(value) == LLVMBitCast {
+        value = LLVMGetOperand(value, 0)
+      } else {
+        return value
+      }
+    }
+  }
+
+  /// Whether an instruction leaves every object's reference count alone.
+  ///
+  /// Only calls run code that could release an object, whether they are
+  /// plain calls or invokes.
+  private func isHarmless(_ inst: LLVMValueRef) -> Bool {
+    guard LLVMIsACallInst(inst) != nil || LLVMIsAInvokeInst(inst) != nil else {
+      return true
+    }
+    guard let callee = LLVMGetCalledValue(inst),
+          LLVMIsAFunction(callee) != nil else {
+      return false
+    }
+    if self.harmless.contains(callee) || LLVMGetIntrinsicID(callee) != 0 {
+      return true
+    }
+    return [self.readNoneKind, self.readOnlyKind].contains { kind in
+      LLVMGetEnumAttributeAtIndex(callee, functionAttributeIndex, kind) != nil
+    }
+  }
+
+  /// Erases a retain, first forwarding its result to its argument.
+  private func erase(_ call: LLVMValueRef) {
+    LLVMReplaceAllUsesWith(call, LLVMGetOperand(call, 0))
+    LLVMInstructionEraseFromParent(call)
+  }
+
+  // MARK: Dead Copies
+
+  private func removeDeadCopies(in function: LLVMValueRef) {
+    var deadPairs = [(LLVMValueRef, LLVMValueRef)]()
+    forEachInstruction(in: function) { inst in
+      guard self.operation(of: inst) == .copyValue,
+            let use = LLVMGetFirstUse(inst), LLVMGetNextUse(use) == nil,
+            let user = LLVMGetUser(use),
+            self.operation(of: user) == .destroyValue,
+            LLVMGetOperand(user, 0) == inst else {
+        return
+      }
+      deadPairs.append((inst, user))
+    }
+    for (copy, destroy) in deadPairs {
+      LLVMInstructionEraseFromParent(destroy)
+      LLVMInstructionEraseFromParent(copy)
+    }
+  }
+
+  // MARK: Pairs
+
+  /// Removes matching retains and releases along each straight-line chain of
+  /// blocks.
+  private func removePairs(in function: LLVMValueRef) {
+    let predecessors = predecessorCounts(in: function)
+    var chainSuccessors = [LLVMBasicBlockRef: LLVMBasicBlockRef]()
+    for bb in blocks(in: function) {
+      let next = successors(of: bb)
+      if next.count == 1, next[0] != bb, predecessors[next[0]] == 1 {
+        chainSuccessors[bb] = next[0]
+      }
+    }
+
+    // Walk chains from their first block, then pick up any cycles.
+    let chained = Set(chainSuccessors.values)
+    let starts = blocks(in: function).filter { !chained.contains($0) }
+               + blocks(in: function).filter { chained.contains($0) }
+    var visited = Set<LLVMBasicBlockRef>()
+    for start in starts where !visited.contains(start) {
+      var chain = [LLVMValueRef]()
+      var link: LLVMBasicBlockRef? = start
+      while let current = link, visited.insert(current).inserted {
+        chain.append(contentsOf: instructions(in: current))
+        link = chainSuccessors[current]
+      }
+      self.removePairs(in: chain)
+    }
+  }
+
+  private func removePairs(in instructions: [LLVMValueRef]) {
+    // Retains and releases not yet matched, in program order.
+    var pending = [(Operation, LLVMValueRef, LLVMValueRef)]()
+    for inst in instructions {
+      guard let operation = self.operation(of: inst),
+            operation == .retain || operation == .release else {
+        if !self.isHarmless(inst) {
+          pending.removeAll()
+        }
+        continue
+      }
+
+      let object = self.object(of: inst)
+      let match = pending.lastIndex { entry in
+        entry.0 != operation && entry.1 == object
+      }
+      if let index = match {
+        let other = pending.remove(at: index).2
+        self.erase(operation == .retain ? inst : other)
+        LLVMInstructionEraseFromParent(operation == .retain ? other : inst)
+        continue
+      }
+
+      if operation == .release {
+        // Releasing another object may run a destructor that releases one
+        // of the retained objects.
+        pending.removeAll { $0.0 == .retain }
+      }
+      pending.append((operation, object, inst))
+    }
+  }
+
+  // MARK: Sinking Releases
+
+  /// Sinks releases at the end of a block into each of its successors if
+  /// one of them begins by retaining the same object.
+  ///
+  ///     release %x                  br %c, %a, %b
+  ///     br %c, %a, %b        ===>   a: release %x; retain %x; ...
+  ///     a: retain %x; ...           b: release %x; ...
+  ///
+  /// Each successor must be reached only from the block, so the release
+  /// still runs exactly once on every path.  Running it later only keeps
+  /// the object alive for longer.
+  private func sinkReleases(
+    in function: LLVMValueRef, _ builder: LLVMBuilderRef
+  ) {
+    let predecessors = predecessorCounts(in: function)
+    for bb in blocks(in: function) {
+      let terminator = LLVMGetBasicBlockTerminator(bb)!
+      let targets = successors(of: bb)
+      guard LLVMIsABranchInst(terminator) != nil
+              || LLVMIsASwitchInst(terminator) != nil,
+            targets.count > 1,
+            Set(targets).count == targets.count,
+            targets.allSatisfy({ predecessors[$0] == 1 }) else {
+        continue
+      }
+
+      // Collect the releases that only harmless instructions or other
+      // releases separate from the terminator.
+      var releases = [LLVMValueRef]()
+      var inst = LLVMGetPreviousInstruction(terminator)
+      while let current = inst {
+        if self.operation(of: current) == .release {
+          releases.append(current)
+        } else if !self.isHarmless(current) {
+          break
+        }
+        inst = LLVMGetPreviousInstruction(current)
+      }
+
+      for release in releases.reversed() {
+        let object = self.object(of: release)
+        guard targets.contains(where: {
+          self.beginsByRetaining(object, $0)
+        }) else {
+          continue
+        }
+        LLVMInstructionRemoveFromParent(release)
+        for (index, target) in targets.enumerated() {
+          let copy = index == 0 ? release : LLVMInstructionClone(release)!
+          LLVMPositionBuilderBefore(builder, firstNonPHI(in: target))
+          LLVMInsertIntoBuilder(builder, copy)
+        }
+      }
+    }
+  }
+
+  /// Whether a block retains an object before anything other than a
+  /// release could release it.
+  private func beginsByRetaining(
+    _ object: LLVMValueRef, _ block: LLVMBasicBlockRef
+  ) -> Bool {
+    for inst in instructions(in: block) {
+      switch self.operation(of: inst) {
+      case .some(.retain) where self.object(of: inst) == object:
+        return true
+      case .some(.release):
+        continue
+      default:
+        if !self.isHarmless(inst) {
+          return false
+        }
+      }
+    }
+    return false
+  }
+
+  // MARK: Loops
+
+  /// Moves retain/release pairs of a loop-invariant object out of loops made
+  /// of a single block.
+  private func hoistLoopInvariantPairs(
+    in function: LLVMValueRef, _ builder: LLVMBuilderRef
+  ) {
+    let predecessors = predecessorCounts(in: function)
+    for loop in blocks(in: function) {
+      // The loop must be entered from a block that always enters it, and
+      // exit to a block that only it reaches.
+      let terminator = LLVMGetBasicBlockTerminator(loop)!
+      guard LLVMGetNumSuccessors(terminator) == 2,
+            predecessors[loop] == 2 else {
+        continue
+      }
+      let successors = [LLVMGetSuccessor(terminator, 0)!,
+                        LLVMGetSuccessor(terminator, 1)!]
+      guard successors.contains(loop),
+            let exit = successors.first(where: { $0 != loop }),
+            predecessors[exit] == 1,
+            let preheader = self.preheader(of: loop, in: function),
+            LLVMGetNumSuccessors(LLVMGetBasicBlockTerminator(preheader)) == 1
+      else {
+        continue
+      }
+
+      var retains = [LLVMValueRef: [LLVMValueRef]]()
+      var releases = [LLVMValueRef: [LLVMValueRef]]()
+      for inst in instructions(in: loop) {
+        switch self.operation(of: inst) {
+        case .some(.retain):
+          retains[self.object(of: inst), default: []].append(inst)
+        case .some(.release):
+          releases[self.object(of: inst), default: []].append(inst)
+        default:
+          continue
+        }
+      }
+
+      for (object, objectRetains) in retains {
+        guard objectRetains.count == 1,
+              let objectReleases = releases[object],
+              objectReleases.count == 1,
+              !isDefined(object, in: loop),
+              precedes(objectRetains[0], objectReleases[0], in: loop) else {
+          continue
+        }
+        let retain = objectRetains[0]
+        let release = objectReleases[0]
+
+        LLVMPositionBuilderBefore(builder,
+                                  LLVMGetBasicBlockTerminator(preheader))
+        let argument = LLVMGetOperand(retain, 0)!
+        if isDefined(argument, in: loop) {
+          // Recreate the cast of the object outside the loop.
+          LLVMSetOperand(retain, 0, LLVMBuildPointerCast(
+            builder, object, LLVMTypeOf(argument), ""))
+        }
+        LLVMReplaceAllUsesWith(retain, argument)
+        LLVMInstructionRemoveFromParent(retain)
+        LLVMInsertIntoBuilder(builder, retain)
+
+        LLVMInstructionRemoveFromParent(release)
+        LLVMPositionBuilderBefore(builder, firstNonPHI(in: exit))
+        LLVMInsertIntoBuilder(builder, release)
+      }
+    }
+  }
+
+  /// The block outside the loop that branches to it.
+  private func preheader(
+    of loop: LLVMBasicBlockRef, in function: LLVMValueRef
+  ) -> LLVMBasicBlockRef? {
+    return blocks(in: function).first { bb in
+      bb != loop && successors(of: bb).contains(loop)
+    }
+  }
+
+  private func isDefined(
+    _ value: LLVMValueRef, in block: LLVMBasicBlockRef
+  ) -> Bool {
+    return LLVMIsAInstruction(value) != nil
+        && LLVMGetInstructionParent(value) == block
+  }
+
+  private func precedes(
+    _ first: LLVMValueRef, _ second: LLVMValueRef,
+    in block: LLVMBasicBlockRef
+  ) -> Bool {
+    for inst in instructions(in: block) {
+      if inst == first {
+        return true
+      }
+      if inst == second {
+        return false
+      }
+    }
+    return false
+  }
+}
+
+/// The index of the attributes of a function itself, as opposed to those of
+/// its return value or parameters.
+let functionAttributeIndex = LLVMAttributeIndex(bitPattern: -1)
+
+// MARK: CFG Utilities
+
+private func blocks(in function: LLVMValueRef) -> [LLVMBasicBlockRef] {
+  var result = [LLVMBasicBlockRef]()
+  var block = LLVMGetFirstBasicBlock(function)
+  while let bb = block {
+    result.append(bb)
+    block = LLVMGetNextBasicBlock(bb)
+  }
+  return result
+}
+
+private func forEachInstruction(
+  in function: LLVMValueRef, _ body: (LLVMValueRef) -> Void
+) {
+  for bb in blocks(in: function) {
+    instructions(in: bb).forEach(body)
+  }
+}
+
+private func instructions(in block: LLVMBasicBlockRef) -> [LLVMValueRef] {
+  var result = [LLVMValueRef]()
+  var inst = LLVMGetFirstInstruction(block)
+  while let i = inst {
+    result.append(i)
+    inst = LLVMGetNextInstruction(i)
+  }
+  return result
+}
+
+private func firstNonPHI(in block: LLVMBasicBlockRef) -> LLVMValueRef {
+  var inst = LLVMGetFirstInstruction(block)!
+  while LLVMIsAPHINode(inst) != nil {
+    inst = LLVMGetNextInstruction(inst)!
+  }
+  return inst
+}
+
+private func successors(of block: LLVMBasicBlockRef) -> [LLVMBasicBlockRef] {
+  guard let terminator = LLVMGetBasicBlockTerminator(block) else {
+    return []
+  }
+  return (0..<LLVMGetNumSuccessors(terminator)).map {
+    LLVMGetSuccessor(terminator, $0)!
+  }
+}
+
+/// Counts the control flow edges into each block of a function.
+private func predecessorCounts(
+  in function: LLVMValueRef
+) -> [LLVMBasicBlockRef: Int] {
+  var counts = [LLVMBasicBlockRef: Int]()
+  for bb in blocks(in: function) {
+    for successor in successors(of: bb) {
+      counts[successor, default: 0] += 1
+    }
+  }
+  return counts
+}
@@ -380,19 +380,19 @@ final class ManagedObjectTypeInfo: HeapTypeInfo {
   }
 
   func initialize(_ IGF: IRGenFunction, _ from: Explosion, _ addr: Address) {
-    IGF.B.buildStore(from.claimSingle(), to: addr.address)
+    IGF.emitStore(from.claimSingle(), to: addr)
   }
 
   func loadAsCopy(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
-    let value = IGF.B.createLoad(addr)
+    let value = IGF.emitLoad(addr)
     self.emitScalarRetain(IGF, value)
     explosion.append(value)
   }
 
   func loadAsTake(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
-    explosion.append(IGF.B.createLoad(addr))
+    explosion.append(IGF.emitLoad(addr))
   }
 
   func copy(_ IGF: IRGenFunction, _ src: Explosion, _ dest: Explosion) {
@@ -434,8 +434,8 @@ final class ManagedObjectTypeInfo: HeapTypeInfo {
 
   func destroy(_ IGF: IRGenFunction,
                _ addr: Address, _ type: GIRType) {
-    let value = IGF.B.createLoad(addr,
-                                 alignment: addr.alignment, name: "toDestroy")
+    let value = IGF.emitLoad(addr,
+                             alignment: addr.alignment, name: "toDestroy")
     self.emitScalarRelease(IGF, value)
   }
 
@@ -495,19 +495,19 @@ extension BoxTypeInfo {
   }
 
   func initialize(_ IGF: IRGenFunction, _ from: Explosion, _ addr: Address) {
-    IGF.B.buildStore(from.claimSingle(), to: addr.address)
+    IGF.emitStore(from.claimSingle(), to: addr)
   }
 
   func loadAsCopy(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
-    let value = IGF.B.createLoad(addr)
+    let value = IGF.emitLoad(addr)
     self.emitScalarRetain(IGF, value)
     explosion.append(value)
   }
 
   func loadAsTake(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
-    explosion.append(IGF.B.createLoad(addr))
+    explosion.append(IGF.emitLoad(addr))
   }
 
   func copy(_ IGF: IRGenFunction, _ src: Explosion, _ dest: Explosion) {
@@ -548,8 +548,8 @@ extension BoxTypeInfo {
   }
 
   func destroy(_ IGF: IRGenFunction, _ addr: Address, _ type: GIRType) {
-    let value = IGF.B.createLoad(addr,
-                                 alignment: addr.alignment, name: "toDestroy")
+    let value = IGF.emitLoad(addr,
+                             alignment: addr.alignment, name: "toDestroy")
     self.emitScalarRelease(IGF, value)
   }
 
@@ -707,24 +707,23 @@ final class FunctionTypeInfo: LoadableTypeInfo {
   func initialize(_ IGF: IRGenFunction, _ from: Explosion, _ addr: Address) {
     // Store the function pointer.
     let fnAddr = self.projectFunction(IGF, addr)
-    IGF.B.buildStore(from.claimSingle(),
-                     to: fnAddr.address, alignment: fnAddr.alignment)
+    IGF.emitStore(from.claimSingle(),
+                  to: fnAddr, alignment: fnAddr.alignment)
 
     // Store the environment pointer.
     let envAddr = self.projectEnvironment(IGF, addr)
     let context = from.claimSingle()
-    IGF.B.buildStore(context,
-                     to: envAddr.address, alignment: envAddr.alignment)
+    IGF.emitStore(context, to: envAddr, alignment: envAddr.alignment)
   }
 
   func loadAsCopy(_ IGF: IRGenFunction,
                   _ addr: Address, _ explosion: Explosion) {
     let fnAddr = self.projectFunction(IGF, addr)
-    let first = IGF.B.createLoad(fnAddr)
+    let first = IGF.emitLoad(fnAddr)
     explosion.append(first)
 
     let envAddr = self.projectEnvironment(IGF, addr)
-    let second = IGF.B.createLoad(envAddr)
+    let second = IGF.emitLoad(envAddr)
     explosion.append(second)
   }
 
@@ -732,11 +731,11 @@ final class FunctionTypeInfo: LoadableTypeInfo {
                   _ addr: Address, _ explosion: Explosion) {
     // Load the function.
     let fnAddr = self.projectFunction(IGF, addr)
-    explosion.append(IGF.B.createLoad(fnAddr))
+    explosion.append(IGF.emitLoad(fnAddr))
 
     // Load the environment pointer.
     let dataAddr = self.projectEnvironment(IGF, addr)
-    explosion.append(IGF.B.createLoad(dataAddr))
+    explosion.append(IGF.emitLoad(dataAddr))
   }
 
   func copy(_ IGF: IRGenFunction, _ src: Explosion, _ dest: Explosion) {
@@ -769,16 +768,16 @@ final class FunctionTypeInfo: LoadableTypeInfo {
   }
 
   func destroy(_ IGF: IRGenFunction, _ addr: Address, _ type: GIRType) {
-    _ = IGF.B.createLoad(self.projectEnvironment(IGF, addr))
+    _ = IGF.emitLoad(self.projectEnvironment(IGF, addr))
     fatalError("Release the data pointer box!")
   }
 
   func assign(_ IGF: IRGenFunction, _ src: Explosion, _ dest: Address) {
     let firstAddr = projectFunction(IGF, dest)
-    IGF.B.buildStore(src.claimSingle(), to: firstAddr.address)
+    IGF.emitStore(src.claimSingle(), to: firstAddr)
 
     let secondAddr = projectEnvironment(IGF, dest)
-    IGF.B.buildStore(src.claimSingle(), to: secondAddr.address)
+    IGF.emitStore(src.claimSingle(), to: secondAddr)
   }
 
   func assignWithCopy(_ IGF: IRGenFunction, _ dest: Address,
@@ -270,12 +270,12 @@ extension SingleScalarizable {
     // Grab the old value if we need to.
     var oldValue: IRValue?
     if !type(of: self).isPOD {
-      oldValue = IGF.B.createLoad(dest, name: "oldValue")
+      oldValue = IGF.emitLoad(dest, name: "oldValue")
     }
 
     // Store.
     let newValue = src.claimSingle()
-    IGF.B.buildStore(newValue, to: dest.address)
+    IGF.emitStore(newValue, to: dest)
 
     // Release the old value if we need to.
     if let valToRelease = oldValue {
@@ -306,7 +306,8 @@ extension FixedHeapLayout {
   func allocate(_ IGF: IRGenFunction, _ boxedType: GIRType) -> OwnedAddress {
     // Allocate a new object using the layout.
     let boxDescriptor = IGF.IGM.addressOfBoxDescriptor(for: boxedType)
-    let allocation = IGF.GR.emitUnmanagedAlloc(self.layout, boxDescriptor)
+    let allocation = IGF.GR.emitUnmanagedAlloc(self.layout, boxDescriptor,
+                                               site: "box of \(boxedType)")
     let rawAddr = project(IGF, allocation, boxedType)
     return OwnedAddress(rawAddr, allocation)
   }
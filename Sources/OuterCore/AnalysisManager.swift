@@ -0,0 +1,143 @@
+/// AnalysisManager.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Seismography
+
+/// The analyses an optimizer pass leaves valid.
+///
+/// A pass that changes the graph must not claim to preserve an analysis that
+/// depends on what it changed.  For example, a pass that only replaces
+/// primops preserves the control flow of a scope, but not its schedule.
+public struct PreservedAnalyses: OptionSet {
+  public let rawValue: Int
+
+  public init(rawValue: Int) {
+    self.rawValue = rawValue
+  }
+
+  /// The partition of the module into top-level scopes.
+  public static let scopes = PreservedAnalyses(rawValue: 1 << 0)
+  /// The reverse post-order and dominator tree of each scope.
+  public static let controlFlow = PreservedAnalyses(rawValue: 1 << 1)
+  /// The schedule of each scope.
+  public static let schedules = PreservedAnalyses(rawValue: 1 << 2)
+
+  /// Every analysis.
+  public static let all: PreservedAnalyses = [
+    .scopes, .controlFlow, .schedules,
+  ]
+}
+
+/// Caches the analyses of a module and its scopes between optimizer passes.
+///
+/// Scopes, orderings and schedules are computed by traversing the graph, and
+/// most passes need at least one of them.  The analysis manager computes
+/// each on first request and keeps it until a pass that does not preserve it
+/// has run.
+///
+/// The analyses of different scopes are cached separately, so passes running
+/// concurrently on separate scopes may request them.  Discovering the scopes
+/// of the module must happen before that.
+public final class AnalysisManager {
+  public let module: GIRModule
+
+  /// The analyses of a single scope.
+  private final class ScopeAnalyses {
+    var reversePostOrder: [Continuation]?
+    var dominatorTree: DominatorTree?
+    var schedule: Schedule?
+  }
+
+  private var scopes: [Scope]?
+  private var scopeAnalyses = [Scope: ScopeAnalyses]()
+
+  public init(module: GIRModule) {
+    self.module = module
+  }
+
+  /// The top-level scopes of the module.
+  public var topLevelScopes: [Scope] {
+    if let scopes = self.scopes {
+      return scopes
+    }
+    let scopes = self.module.topLevelScopes
+    self.scopes = scopes
+    for scope in scopes {
+      self.scopeAnalyses[scope] = ScopeAnalyses()
+    }
+    return scopes
+  }
+
+  /// Returns the continuations of a scope reachable from its entry, in
+  /// reverse post-order.
+  public func reversePostOrder(of scope: Scope) -> [Continuation] {
+    let analyses = self.analyses(of: scope)
+    if let order = analyses.reversePostOrder {
+      return order
+    }
+    let order = Array(scope.reversePostOrder)
+    analyses.reversePostOrder = order
+    return order
+  }
+
+  /// Returns the dominator tree of a scope.
+  public func dominatorTree(of scope: Scope) -> DominatorTree {
+    let analyses = self.analyses(of: scope)
+    if let tree = analyses.dominatorTree {
+      return tree
+    }
+    let tree = DominatorTree(scope)
+    analyses.dominatorTree = tree
+    return tree
+  }
+
+  /// Returns the early schedule of a scope.
+  public func schedule(of scope: Scope) -> Schedule {
+    let analyses = self.analyses(of: scope)
+    if let schedule = analyses.schedule {
+      return schedule
+    }
+    let schedule = Schedule(scope, .early,
+                            order: self.reversePostOrder(of: scope))
+    analyses.schedule = schedule
+    return schedule
+  }
+
+  /// Discards the analyses of a scope that a pass did not preserve.
+  ///
+  /// Discovery of scopes is a module-wide analysis and must be invalidated
+  /// with `invalidateAll(preserving:)`.
+  public func invalidate(_ scope: Scope, preserving: PreservedAnalyses) {
+    guard let analyses = self.scopeAnalyses[scope] else {
+      return
+    }
+    if !preserving.contains(.controlFlow) {
+      analyses.reversePostOrder = nil
+      analyses.dominatorTree = nil
+    }
+    if !preserving.contains(.schedules) {
+      analyses.schedule = nil
+    }
+  }
+
+  /// Discards every analysis a pass did not preserve.
+  public func invalidateAll(preserving: PreservedAnalyses = []) {
+    guard preserving.contains(.scopes) else {
+      self.scopes = nil
+      self.scopeAnalyses.removeAll()
+      return
+    }
+    for scope in self.scopeAnalyses.keys {
+      self.invalidate(scope, preserving: preserving)
+    }
+  }
+
+  private func analyses(of scope: Scope) -> ScopeAnalyses {
+    // Scopes that were not discovered here get analyses that are not kept.
+    return self.scopeAnalyses[scope] ?? ScopeAnalyses()
+  }
+}
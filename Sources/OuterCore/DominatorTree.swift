@@ -0,0 +1,159 @@
+/// DominatorTree.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Seismography
+
+/// The dominator tree of the continuations in a scope.
+///
+/// A continuation dominates another if every path of branches to the other
+/// passes through it.  Paths start at the entry of the scope, but also at
+/// any continuation that is branched to from outside the scope or that no
+/// branch within the scope reaches, such as the return points of calls.
+/// These continuations are the roots of the tree.
+///
+/// The tree is computed with the iterative algorithm of Cooper, Harvey and
+/// Kennedy in "A Simple, Fast Dominance Algorithm".
+public final class DominatorTree {
+  public let scope: Scope
+
+  /// The continuations of the scope in post-order.
+  private var postorder = [Continuation]()
+  /// The post-order index of each continuation.
+  private var indices = [Continuation: Int]()
+  /// The post-order index of the immediate dominator of each continuation,
+  /// or the number of continuations for roots.
+  private var idoms = [Int]()
+  /// The continuations immediately dominated by each continuation.
+  private var childLists = [[Continuation]]()
+
+  /// The roots of the tree, starting with the entry of the scope.
+  public private(set) var roots = [Continuation]()
+
+  public init(_ scope: Scope) {
+    self.scope = scope
+
+    let members = Set(scope.continuations)
+    var starts = [scope.entry]
+    for cont in scope.continuations where cont !== scope.entry {
+      if cont.predecessors.contains(where: { !members.contains($0) }) {
+        starts.append(cont)
+      }
+    }
+    starts.append(contentsOf: scope.continuations)
+
+    // Number the continuations in the post-order of a depth-first search
+    // from a virtual root whose successors are the roots of the tree.
+    var visited = Set<Continuation>()
+    for start in starts where !visited.contains(start) {
+      self.roots.append(start)
+      self.traverse(start, members, &visited)
+    }
+    let virtualRoot = self.postorder.count
+    let rootSet = Set(self.roots)
+
+    self.idoms = [Int](repeating: -1, count: virtualRoot + 1)
+    self.idoms[virtualRoot] = virtualRoot
+    var changed = true
+    while changed {
+      changed = false
+      for index in (0..<virtualRoot).reversed() {
+        let cont = self.postorder[index]
+        var preds = cont.predecessors.compactMap { self.indices[$0] }
+        if rootSet.contains(cont) {
+          preds.append(virtualRoot)
+        }
+        var newIdom = -1
+        for pred in preds where self.idoms[pred] != -1 {
+          newIdom = newIdom == -1 ? pred : self.intersect(pred, newIdom)
+        }
+        if self.idoms[index] != newIdom {
+          self.idoms[index] = newIdom
+          changed = true
+        }
+      }
+    }
+
+    self.childLists = [[Continuation]](repeating: [], count: virtualRoot)
+    for index in (0..<virtualRoot).reversed() {
+      let idom = self.idoms[index]
+      guard idom != virtualRoot else {
+        continue
+      }
+      self.childLists[idom].append(self.postorder[index])
+    }
+  }
+
+  private func traverse(
+    _ cont: Continuation, _ members: Set<Continuation>,
+    _ visited: inout Set<Continuation>
+  ) {
+    visited.insert(cont)
+    for succ in cont.successors {
+      guard members.contains(succ) && !visited.contains(succ) else {
+        continue
+      }
+      self.traverse(succ, members, &visited)
+    }
+    self.indices[cont] = self.postorder.count
+    self.postorder.append(cont)
+  }
+
+  private func intersect(_ lhs: Int, _ rhs: Int) -> Int {
+    var finger1 = lhs
+    var finger2 = rhs
+    while finger1 != finger2 {
+      while finger1 < finger2 {
+        finger1 = self.idoms[finger1]
+      }
+      while finger2 < finger1 {
+        finger2 = self.idoms[finger2]
+      }
+    }
+    return finger1
+  }
+
+  /// Returns the immediate dominator of a continuation, or `nil` if it is a
+  /// root of the tree.
+  public func immediateDominator(of cont: Continuation) -> Continuation? {
+    guard let index = self.indices[cont] else {
+      return nil
+    }
+    let idom = self.idoms[index]
+    guard idom < self.postorder.count else {
+      return nil
+    }
+    return self.postorder[idom]
+  }
+
+  /// Returns the continuations a continuation immediately dominates, in
+  /// reverse post-order.
+  public func children(of cont: Continuation) -> [Continuation] {
+    guard let index = self.indices[cont] else {
+      return []
+    }
+    return self.childLists[index]
+  }
+
+  /// Returns whether every path to one continuation passes through another.
+  ///
+  /// Every continuation dominates itself.
+  public func dominates(_ dominator: Continuation,
+                        _ dominated: Continuation) -> Bool {
+    guard
+      let target = self.indices[dominator],
+      var index = self.indices[dominated]
+    else {
+      return false
+    }
+    // Dominators have higher post-order indices than the continuations they
+    // dominate.
+    while index < target {
+      index = self.idoms[index]
+    }
+    return index == target
+  }
+}
@@ -0,0 +1,222 @@
+/// EffectSummary.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Seismography
+
+/// Summarizes the side effects a scope may have when it is called.
+///
+/// Silt functions are pure, but the code that implements them is not: values
+/// are reference counted, boxes are allocated and freed, and results may be
+/// written through an indirect return address.  An effect summary records
+/// which memory a scope may read or write so a backend can tell its optimizer
+/// which calls may be reused, moved or removed.
+///
+/// The summary is computed from a schedule, so it covers exactly the primops
+/// that will be lowered.  In particular, the stores a `force_effects`
+/// sequences before its subject are scheduled with it and counted like any
+/// other store, even though `force_effects` itself does nothing.
+public struct EffectSummary {
+  /// The ways a scope may access a kind of memory.
+  public struct Access: OptionSet {
+    public let rawValue: UInt8
+
+    public init(rawValue: UInt8) {
+      self.rawValue = rawValue
+    }
+
+    public static let read = Access(rawValue: 1 << 0)
+    public static let write = Access(rawValue: 1 << 1)
+    public static let readWrite: Access = [.read, .write]
+  }
+
+  /// How the values of a type are handled by lowered code.
+  public enum Representation {
+    /// Copied, moved and destroyed as plain bits.
+    case trivial
+    /// Held directly, but copied and destroyed by reference counting.
+    case referenceCounted
+    /// Manipulated only through calls into the runtime.
+    case opaque
+  }
+
+  /// Accesses to memory the scope's entry receives the address of.
+  public var argumentMemory: Access = []
+
+  /// Accesses to any other memory visible to the caller, including heap
+  /// objects and the reference counts of values.
+  ///
+  /// Stack memory the scope allocates for itself is not visible to the
+  /// caller, and accesses to it are not recorded.
+  public var otherMemory: Access = []
+
+  /// Whether a call to the scope may fail to return: it loops, reaches an
+  /// `unreachable`, or calls something unknown.
+  public var mayNotReturn = false
+
+  /// Whether the scope neither accesses memory nor fails to return.  Calls to
+  /// a pure scope with the same arguments always produce the same result.
+  public var isPure: Bool {
+    return self.argumentMemory.isEmpty && self.otherMemory.isEmpty
+        && !self.mayNotReturn
+  }
+
+  /// Computes the effects of the scope a schedule was built for.
+  ///
+  /// - Parameters:
+  ///   - schedule: The schedule of the scope.
+  ///   - representation: Describes how values of a given type are lowered.
+  public init(
+    _ schedule: Schedule,
+    representation: (GIRType) -> Representation
+  ) {
+    let scope = schedule.scope
+    self.mayNotReturn = EffectSummary.containsCycle(scope)
+    for block in schedule.blocks {
+      for primop in block.primops {
+        self.add(primop, in: scope, representation)
+      }
+    }
+  }
+
+  private mutating func add(
+    _ primop: PrimOp, in scope: Scope,
+    _ representation: (GIRType) -> Representation
+  ) {
+    switch primop {
+    case let op as AllocaOp:
+      self.addRuntimeCall(if: representation(op.addressType) == .opaque)
+    case let op as DeallocaOp:
+      self.addRuntimeCall(
+        if: representation(op.addressValue.type) == .opaque)
+    case let op as CopyValueOp:
+      self.addRuntimeCall(if: representation(op.value.value.type) != .trivial)
+    case let op as DestroyValueOp:
+      self.addRuntimeCall(if: representation(op.value.value.type) != .trivial)
+    case let op as LoadOp:
+      self.add(.read, to: op.addressee, in: scope)
+      switch (op.ownership, representation(op.type)) {
+      case (_, .opaque), (.copy, .referenceCounted):
+        self.addRuntimeCall()
+      default:
+        break
+      }
+    case let op as StoreOp:
+      self.add(.write, to: op.address, in: scope)
+      self.addRuntimeCall(if: representation(op.value.type) == .opaque)
+    case let op as CopyAddressOp:
+      self.add(.read, to: op.value, in: scope)
+      self.add(.write, to: op.address, in: scope)
+      self.addRuntimeCall(if: representation(op.value.type) != .trivial)
+    case let op as DestroyAddressOp:
+      if representation(op.value.type) != .trivial {
+        self.add(.readWrite, to: op.value, in: scope)
+        self.addRuntimeCall()
+      }
+    case is AllocBoxOp, is DeallocBoxOp:
+      self.addRuntimeCall()
+    case let op as ProjectBoxOp:
+      // The address of a box allocated in this scope is already known.
+      self.addRuntimeCall(if: !(op.boxValue is AllocBoxOp))
+    case let op as TupleElementAddressOp:
+      // The offsets of opaque elements are read from type metadata.
+      if representation(op.tuple.type) == .opaque {
+        self.otherMemory.formUnion(.read)
+      }
+    case let op as DataInitOp:
+      self.addRuntimeCall(if: representation(op.dataType) == .opaque)
+    case let op as DataExtractOp:
+      self.addRuntimeCall(if: representation(op.dataValue.type) == .opaque)
+    case let op as SwitchConstrOp:
+      self.addRuntimeCall(if: representation(op.matchedValue.type) == .opaque)
+    case let op as ApplyOp:
+      self.add(op, in: scope)
+    case is UnreachableOp:
+      self.mayNotReturn = true
+    case is FunctionRefOp, is ThickenOp, is TupleOp, is ForceEffectsOp,
+         is NoOp:
+      break
+    default:
+      self.addRuntimeCall()
+      self.mayNotReturn = true
+    }
+  }
+
+  private mutating func add(_ apply: ApplyOp, in scope: Scope) {
+    switch apply.callee {
+    case let funcRef as FunctionRefOp
+        where scope.continuations.contains(funcRef.function):
+      // A branch within the scope.
+      break
+    case let param as Parameter where param == scope.entry.parameters.last:
+      // A return.
+      break
+    default:
+      self.addRuntimeCall()
+      self.mayNotReturn = true
+    }
+  }
+
+  /// Records an access to the memory at an address.
+  private mutating func add(
+    _ access: Access, to address: Value, in scope: Scope
+  ) {
+    var address = address
+    while true {
+      switch address {
+      case let op as TupleElementAddressOp:
+        address = op.tuple
+      case let op as StoreOp:
+        address = op.address
+      case let op as ForceEffectsOp:
+        address = op.subject
+      case is AllocaOp:
+        return
+      case let param as Parameter where param.parent == scope.entry:
+        self.argumentMemory.formUnion(access)
+        return
+      default:
+        self.otherMemory.formUnion(access)
+        return
+      }
+    }
+  }
+
+  /// Records a call into the runtime, which may read and write any memory
+  /// visible to the scope, if the condition holds.
+  private mutating func addRuntimeCall(if condition: Bool = true) {
+    guard condition else {
+      return
+    }
+    self.argumentMemory = .readWrite
+    self.otherMemory = .readWrite
+  }
+
+  /// Returns whether control can flow around a cycle within the scope.
+  private static func containsCycle(_ scope: Scope) -> Bool {
+    let members = Set(scope.continuations)
+    var finished = Set<Continuation>()
+    var active = Set<Continuation>()
+    var stack = [(scope.entry, scope.entry.successors[...])]
+    active.insert(scope.entry)
+    while !stack.isEmpty {
+      guard let next = stack[stack.count - 1].1.popFirst() else {
+        let (done, _) = stack.removeLast()
+        active.remove(done)
+        finished.insert(done)
+        continue
+      }
+      guard members.contains(next), !finished.contains(next) else {
+        continue
+      }
+      guard active.insert(next).inserted else {
+        return true
+      }
+      stack.append((next, next.successors[...]))
+    }
+    return false
+  }
+}
@@ -0,0 +1,125 @@
+/// GlobalValueNumbering.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Seismography
+
+/// Replaces pure primops with equivalent primops that dominate them.
+///
+/// GIRGen, and the Inliner, create a fresh primop for every projection and
+/// reconstruction of a value, so the same `function_ref`, `data_extract` or
+/// `tuple` often appears many times in a scope.  Two pure primops are
+/// equivalent if they have the same opcode, operands and type, and the same
+/// constructor or element index where they have one.
+///
+///     bb0(%0 : Nat ; %return : (Nat) -> _):
+///       %1 = data_extract %0 : Nat ; #succ
+///       %2 = data_extract %0 : Nat ; #succ
+///       %3 = tuple (%1, %2)
+///
+/// ===>
+///
+///     bb0(%0 : Nat ; %return : (Nat) -> _):
+///       %1 = data_extract %0 : Nat ; #succ
+///       %3 = tuple (%1, %1)
+///
+/// The scope's continuations are visited in the preorder of its dominator
+/// tree, and a primop is only replaced by one scheduled in a continuation
+/// that dominates it.  Equivalent primops have identical operands, so the
+/// survivor can be computed everywhere the primop it replaces was used.
+///
+/// Only primops that IRGen lowers without side effects or ownership
+/// transfer are numbered.
+final class GlobalValueNumbering: ScopePass {
+  /// The primops available in the continuations on the current path through
+  /// the dominator tree.
+  private var available = [Expression: PrimOp]()
+  /// The expressions made available by each continuation on the current
+  /// path through the dominator tree.
+  private var scopes = [[Expression]]()
+  /// The primops that have been replaced.
+  private var replaced = Set<PrimOp>()
+
+  /// Only primops are replaced, so the control flow of the scope is left
+  /// alone.
+  static var preservedAnalyses: PreservedAnalyses {
+    return [.scopes, .controlFlow]
+  }
+
+  func run(on scope: Scope, analyses: AnalysisManager) {
+    self.replaced.removeAll()
+    let schedule = analyses.schedule(of: scope)
+    let dominators = analyses.dominatorTree(of: scope)
+    for root in dominators.roots {
+      self.visit(root, schedule, dominators)
+    }
+  }
+
+  private func visit(
+    _ cont: Continuation, _ schedule: Schedule, _ dominators: DominatorTree
+  ) {
+    self.scopes.append([])
+    for primop in schedule.block(cont).primops {
+      self.number(primop)
+    }
+    for child in dominators.children(of: cont) {
+      self.visit(child, schedule, dominators)
+    }
+    for expr in self.scopes.removeLast() {
+      self.available.removeValue(forKey: expr)
+    }
+  }
+
+  private func number(_ primop: PrimOp) {
+    guard
+      !self.replaced.contains(primop),
+      let expr = Expression(primop)
+    else {
+      return
+    }
+    guard let leader = self.available[expr] else {
+      self.available[expr] = primop
+      self.scopes[self.scopes.count - 1].append(expr)
+      return
+    }
+    guard leader !== primop else {
+      return
+    }
+    primop.replaceAllUsesWith(leader)
+    self.replaced.insert(primop)
+  }
+}
+
+/// The value a pure primop computes.
+private struct Expression: Hashable {
+  let opcode: PrimOp.Code
+  let operands: [ObjectIdentifier]
+  /// The type of the result, if the operands do not determine it.
+  let type: ObjectIdentifier?
+  /// The constructor of a `data_extract`, or the element index of a
+  /// `tuple_element_address`.
+  let selector: String
+
+  /// Returns the expression a primop computes, or `nil` if the primop must
+  /// not be merged with others.
+  init?(_ primop: PrimOp) {
+    switch primop {
+    case let op as DataExtractOp:
+      self.selector = op.constructor
+      self.type = ObjectIdentifier(op.type)
+    case let op as TupleElementAddressOp:
+      self.selector = String(op.index)
+      self.type = nil
+    case is FunctionRefOp, is ThickenOp, is TupleOp:
+      self.selector = ""
+      self.type = nil
+    default:
+      return nil
+    }
+    self.opcode = primop.opcode
+    self.operands = primop.operands.map { ObjectIdentifier($0.value) }
+  }
+}
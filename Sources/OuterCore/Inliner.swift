@@ -0,0 +1,398 @@
+/// Inliner.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Seismography
+
+/// Inlines calls to small top-level functions into their callers.
+///
+/// In GraphIR a call is an `apply` of a top-level continuation whose last
+/// argument is the continuation to return to: either a basic-block-like
+/// continuation of the caller or, for a tail call, the caller's own return
+/// parameter.  Inlining a call clones the callee's continuations into the
+/// caller, substituting the call's arguments for the callee's parameters.
+/// The callee's entry takes the place of the call, and each of its returns
+/// becomes a branch to the return continuation of the call, or a return from
+/// the caller.
+///
+///     bb0(%0 : Nat ; %return : (Bool) -> _):
+///       %1 = function_ref @isZero
+///       %2 = function_ref @bb1
+///       apply %1(%0 ; %2)
+///
+/// ===>
+///
+///     bb0(%0 : Nat ; %return : (Bool) -> _):
+///       <the body of @isZero, returning to @bb1>
+///
+/// Whether to inline a callee is decided by the number of primops in its
+/// body and the number of calls to it.  Recursive and polymorphic callees
+/// are never inlined.  Top-level functions stay in the module after their
+/// calls are inlined, as other modules may call them.
+///
+/// Only the calls present when the pass starts are considered, so calls
+/// exposed by inlining are left for the next run.
+final class Inliner: ModulePass {
+  /// Callees of at most this many primops are inlined at every call site.
+  static let alwaysInlineLimit = 12
+
+  /// The most primops inlining every call to a callee may add to a module.
+  static let growthLimit = 60
+
+  /// A counter used to name the continuations cloned into callers.
+  private var instanceCount = 0
+
+  func run(on module: GIRModule) {
+    let B = GIRBuilder(module: module)
+
+    var callSites = [ApplyOp]()
+    var callCounts = [ObjectIdentifier: Int]()
+    for cont in module.continuations {
+      guard
+        let apply = cont.terminalOp as? ApplyOp,
+        let callee = self.topLevelCallee(of: apply)
+      else {
+        continue
+      }
+      callSites.append(apply)
+      callCounts[ObjectIdentifier(callee), default: 0] += 1
+    }
+
+    for site in callSites {
+      // Inlining into one continuation never replaces the terminal of
+      // another, but be defensive about it.
+      guard
+        site.parent.terminalOp === site,
+        let callee = self.topLevelCallee(of: site),
+        let body = FunctionBody(callee)
+      else {
+        continue
+      }
+      let calls = callCounts[ObjectIdentifier(callee), default: 1]
+      guard
+        body.size <= Inliner.alwaysInlineLimit
+          || body.size * calls <= Inliner.growthLimit,
+        self.canInline(site, body)
+      else {
+        continue
+      }
+      self.inline(site, body, B)
+      callCounts[ObjectIdentifier(callee)] = calls - 1
+    }
+  }
+
+  /// Returns the top-level continuation an `apply` calls, if any.
+  private func topLevelCallee(of apply: ApplyOp) -> Continuation? {
+    guard
+      let ref = apply.callee as? FunctionRefOp,
+      ref.function.bblikeSuffix == nil
+    else {
+      return nil
+    }
+    return ref.function
+  }
+
+  private func canInline(_ site: ApplyOp, _ body: FunctionBody) -> Bool {
+    let callee = body.entry
+    guard
+      !body.isRecursive,
+      !callee.parameters.isEmpty,
+      site.arguments.count == callee.parameters.count
+    else {
+      return false
+    }
+
+    // Types may be passed as arguments, and the callee's types may then
+    // refer to its parameters.  Substituting into types is not supported.
+    guard !callee.parameters.contains(where: { $0.type is TypeType }) else {
+      return false
+    }
+
+    // IRGen lowers applies of function references as branches and applies
+    // of the return parameter as returns, so after substitution the callee's
+    // return parameter must become one or the other.
+    switch site.arguments.last!.value {
+    case let ref as FunctionRefOp:
+      return ref.function.bblikeSuffix != nil
+    case let param as Parameter:
+      return param.parent.bblikeSuffix == nil
+          && param === param.parent.parameters.last
+    default:
+      return false
+    }
+  }
+
+  private func inline(_ site: ApplyOp, _ body: FunctionBody, _ B: GIRBuilder) {
+    let caller = site.parent
+    let cloner = BodyCloner(B)
+    for (param, arg) in zip(body.entry.parameters, site.arguments) {
+      cloner.map(param, to: arg.value)
+    }
+
+    // The entry's own body replaces the call, and every other continuation
+    // of the callee becomes a continuation of the caller.
+    let instance = self.freshInstanceTag(caller, body, B.module)
+    var clones = [Continuation]()
+    for cont in body.continuations.dropFirst() {
+      let clone = B.buildBBLikeContinuation(
+        base: caller.name, tag: instance + cont.bblikeSuffix!)
+      cloner.map(cont, to: clone)
+      for param in cont.parameters {
+        let type = cloner.clone(param.type)
+        cloner.map(param, to: clone.appendParameter(type: type))
+      }
+      clones.append(clone)
+    }
+
+    for operand in site.operands {
+      operand.drop()
+    }
+    cloner.cloneBody(of: body.entry, into: caller)
+    for (cont, clone) in zip(body.continuations.dropFirst(), clones) {
+      cloner.cloneBody(of: cont, into: clone)
+    }
+  }
+
+  /// Returns a tag that gives the continuations cloned from a callee names
+  /// no other continuation of the caller has.
+  private func freshInstanceTag(
+    _ caller: Continuation, _ body: FunctionBody, _ module: GIRModule
+  ) -> String {
+    while true {
+      let tag = "_inline\(self.instanceCount)"
+      self.instanceCount += 1
+      let taken = body.continuations.dropFirst().contains { cont in
+        let name = caller.name.string + tag + cont.bblikeSuffix!
+        return module.lookupContinuation(DeclRef(name, .function)) != nil
+      }
+      if !taken {
+        return tag
+      }
+    }
+  }
+}
+
+/// The continuations and primops that make up a top-level function.
+private struct FunctionBody {
+  /// The function's entry, followed by the basic-block-like continuations
+  /// it branches and returns to.
+  let continuations: [Continuation]
+  /// The number of primops, including terminators, in the body.
+  let size: Int
+  /// Whether the body refers to the function itself.
+  let isRecursive: Bool
+
+  var entry: Continuation {
+    return self.continuations[0]
+  }
+
+  /// Gathers the body of a function, or returns `nil` if any of it is only
+  /// declared.
+  ///
+  /// A basic-block-like continuation belongs to the body if a primop of the
+  /// body refers to it, however indirectly: as a successor, or through the
+  /// operands of the terminator and cleanups, such as a `thicken` of its
+  /// `function_ref` passed as an argument.
+  init?(_ entry: Continuation) {
+    var continuations = [entry]
+    var seen: Set<ObjectIdentifier> = [ObjectIdentifier(entry)]
+    var visited = Set<ObjectIdentifier>()
+    var isRecursive = false
+    var index = 0
+    while index < continuations.count {
+      let cont = continuations[index]
+      index += 1
+      guard let terminal = cont.terminalOp else {
+        return nil
+      }
+
+      var targets = terminal.successors.compactMap { $0.successor }
+      var primops: [PrimOp] = [terminal]
+      primops.append(contentsOf: cont.cleanups)
+      while let op = primops.popLast() {
+        guard visited.insert(ObjectIdentifier(op)).inserted else {
+          continue
+        }
+        if let ref = op as? FunctionRefOp {
+          isRecursive = isRecursive || ref.function === entry
+          targets.append(ref.function)
+        }
+        for operand in op.operands {
+          if let primop = operand.value as? PrimOp {
+            primops.append(primop)
+          }
+        }
+      }
+
+      for target in targets where target.bblikeSuffix != nil {
+        if seen.insert(ObjectIdentifier(target)).inserted {
+          continuations.append(target)
+        }
+      }
+    }
+
+    self.continuations = continuations
+    self.size = visited.count
+    self.isRecursive = isRecursive
+  }
+}
+
+/// Copies the bodies of continuations, substituting values for the
+/// parameters and continuations they refer to.
+///
+/// Every primop reachable from a cloned body is copied once, so values
+/// owned by the original are never shared with the copy.  References to
+/// continuations that aren't cloned are shared.
+private final class BodyCloner: PrimOpVisitor {
+  typealias Ret = PrimOp
+
+  let B: GIRBuilder
+  private var values = [ObjectIdentifier: Value]()
+  /// The continuation whose terminator is being cloned.
+  private var parent: Continuation?
+
+  init(_ B: GIRBuilder) {
+    self.B = B
+  }
+
+  /// Substitutes a value for all references to another.
+  func map(_ value: Value, to clone: Value) {
+    self.values[ObjectIdentifier(value)] = clone
+  }
+
+  /// Returns the value substituted for a value, cloning it if it is a
+  /// primop that has not yet been cloned.
+  func clone(_ value: Value) -> Value {
+    if let clone = self.values[ObjectIdentifier(value)] {
+      return clone
+    }
+    guard let op = value as? PrimOp, !(op is TerminalOp) else {
+      return value
+    }
+    let clone = self.visitPrimOp(op)
+    self.map(op, to: clone)
+    return clone
+  }
+
+  /// Clones the cleanups and terminator of a continuation into another.
+  func cloneBody(of source: Continuation, into dest: Continuation) {
+    self.parent = dest
+    defer { self.parent = nil }
+    for cleanup in source.cleanups {
+      dest.appendCleanupOp(self.visitPrimOp(cleanup))
+    }
+    _ = self.visitPrimOp(source.terminalOp!)
+  }
+
+  private func cloneFunctionRef(_ ref: FunctionRefOp) -> FunctionRefOp {
+    // swiftlint:disable force_cast
+    return self.clone(ref) as! FunctionRefOp
+  }
+
+  func visitAllocaOp(_ op: AllocaOp) -> PrimOp {
+    return B.createAlloca(self.clone(op.addressType))
+  }
+
+  func visitApplyOp(_ op: ApplyOp) -> PrimOp {
+    return B.createApply(self.parent!, self.clone(op.callee),
+                         op.arguments.map { self.clone($0.value) })
+  }
+
+  func visitDeallocaOp(_ op: DeallocaOp) -> PrimOp {
+    return B.createDealloca(self.clone(op.addressValue))
+  }
+
+  func visitCopyValueOp(_ op: CopyValueOp) -> PrimOp {
+    return B.createCopyValue(self.clone(op.value.value))
+  }
+
+  func visitDestroyValueOp(_ op: DestroyValueOp) -> PrimOp {
+    return B.createDestroyValue(self.clone(op.value.value))
+  }
+
+  func visitCopyAddressOp(_ op: CopyAddressOp) -> PrimOp {
+    return B.createCopyAddress(self.clone(op.value),
+                               to: self.clone(op.address))
+  }
+
+  func visitDestroyAddressOp(_ op: DestroyAddressOp) -> PrimOp {
+    return B.createDestroyAddress(self.clone(op.value))
+  }
+
+  func visitFunctionRefOp(_ op: FunctionRefOp) -> PrimOp {
+    guard let function = self.clone(op.function) as? Continuation,
+          function !== op.function else {
+      return op
+    }
+    return B.createFunctionRef(function)
+  }
+
+  func visitSwitchConstrOp(_ op: SwitchConstrOp) -> PrimOp {
+    let patterns = op.patterns.map { pattern in
+      return (pattern.pattern, self.cloneFunctionRef(pattern.destination))
+    }
+    return B.createSwitchConstr(self.parent!, self.clone(op.matchedValue),
+                                patterns, op.default.map(self.cloneFunctionRef))
+  }
+
+  func visitDataInitOp(_ op: DataInitOp) -> PrimOp {
+    return B.createDataInit(op.constructor, self.clone(op.dataType),
+                            op.argumentTuple.map(self.clone))
+  }
+
+  func visitDataExtractOp(_ op: DataExtractOp) -> PrimOp {
+    return B.createDataExtract(op.constructor,
+                               self.clone(op.operands[0].value),
+                               self.clone(op.type))
+  }
+
+  func visitTupleOp(_ op: TupleOp) -> PrimOp {
+    return B.createTuple(op.operands.map { self.clone($0.value) })
+  }
+
+  func visitTupleElementAddress(_ op: TupleElementAddressOp) -> PrimOp {
+    return B.createTupleElementAddress(self.clone(op.tuple), op.index)
+  }
+
+  func visitLoadOp(_ op: LoadOp) -> PrimOp {
+    return B.createLoad(self.clone(op.addressee), op.ownership)
+  }
+
+  func visitStoreOp(_ op: StoreOp) -> PrimOp {
+    return B.createStore(self.clone(op.value), to: self.clone(op.address))
+  }
+
+  func visitAllocBoxOp(_ op: AllocBoxOp) -> PrimOp {
+    return B.createAllocBox(self.clone(op.boxedType))
+  }
+
+  func visitProjectBoxOp(_ op: ProjectBoxOp) -> PrimOp {
+    return B.createProjectBox(self.clone(op.boxValue),
+                              type: self.clone(op.type))
+  }
+
+  func visitDeallocBoxOp(_ op: DeallocBoxOp) -> PrimOp {
+    return B.createDeallocBox(self.clone(op.box))
+  }
+
+  func visitThickenOp(_ op: ThickenOp) -> PrimOp {
+    guard let ref = op.function as? FunctionRefOp else {
+      fatalError("thicken of a value that is not a function_ref")
+    }
+    return B.createThicken(self.cloneFunctionRef(ref))
+  }
+
+  func visitUnreachableOp(_ op: UnreachableOp) -> PrimOp {
+    return B.createUnreachable(self.parent!)
+  }
+
+  func visitForceEffectsOp(_ op: ForceEffectsOp) -> PrimOp {
+    return B.createForceEffects(self.clone(op.subject),
+                                op.operands.dropFirst().map {
+                                  self.clone($0.value)
+                                })
+  }
+}
@@ -0,0 +1,36 @@
+/// OptimizationLevel.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+/// The level of optimization requested by `-O`.
+///
+/// The same level drives both the GraphIR pass pipeline and the LLVM
+/// pipeline run on the lowered module.
+public enum OptimizationLevel: String, Comparable {
+  /// Perform no optimizations.  This is the default.
+  case none = "0"
+  /// Perform quick, local optimizations.
+  case less = "1"
+  /// Perform the standard set of optimizations.
+  case `default` = "2"
+  /// Perform optimizations that trade compile time for faster code.
+  case aggressive = "3"
+
+  /// The numeric level, as used by LLVM.
+  public var level: Int {
+    switch self {
+    case .none: return 0
+    case .less: return 1
+    case .default: return 2
+    case .aggressive: return 3
+    }
+  }
+
+  public static func < (lhs: OptimizationLevel,
+                        rhs: OptimizationLevel) -> Bool {
+    return lhs.level < rhs.level
+  }
+}
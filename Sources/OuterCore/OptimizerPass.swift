@@ -58,12 +58,30 @@ import Seismography
 public protocol OptimizerPass: class {
   /// Create and return a value of this type.
   init()
+
+  /// The analyses that remain valid after this pass has run.
+  ///
+  /// The `PassPipeliner` discards every other analysis of the scopes, or
+  /// the module, the pass ran on.
+  static var preservedAnalyses: PreservedAnalyses { get }
+}
+
+extension OptimizerPass {
+  /// By default, a pass is assumed to invalidate every analysis.
+  public static var preservedAnalyses: PreservedAnalyses {
+    return []
+  }
 }
 
 /// An optimizer pass that is run on every scope in a module.
 public protocol ScopePass: OptimizerPass {
   /// Execute the pass on the given scope.
-  func run(on scope: Scope)
+  ///
+  /// - Parameters:
+  ///   - scope: The scope to transform.
+  ///   - analyses: The cached analyses of the module.  Only the analyses of
+  ///               the given scope may be requested.
+  func run(on scope: Scope, analyses: AnalysisManager)
 }
 
 /// An optimizer pass that is run on the entire module.
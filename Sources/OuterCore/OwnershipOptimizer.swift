@@ -0,0 +1,184 @@
+/// OwnershipOptimizer.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Seismography
+
+/// Removes redundant copies and destroys of values.
+///
+/// GIRGen copies a value whenever it needs an owned value, and destroys
+/// whatever it still owns on the way out of a continuation.  Many of these
+/// copies and destroys cancel out, and each one is a retain or release at
+/// runtime.
+///
+/// - A copy of a value that is destroyed by the same continuation is
+///   replaced by the value itself, and the destroy removed.  The value is
+///   forwarded to wherever the copy was consumed.
+///
+///       %1 = copy_value %0 : Nat
+///       apply %f(%1 ; %return)
+///       destroy_value %0 : Nat
+///
+///   ===>
+///
+///       apply %f(%0 ; %return)
+///
+/// - A copy that is only borrowed, then destroyed by the same continuation,
+///   is removed along with its destroy.
+/// - A `load [copy]` from memory that is then destroyed without being read
+///   again becomes a `load [take]`, and the `destroy_address` is removed.
+///
+/// Primops float between the continuations that use them, and the scheduler
+/// computes a primop in every continuation that uses it.  Ownership can only
+/// be reasoned about one continuation at a time, so a copy or load is only
+/// rewritten if it, and every user of it, is scheduled in the continuation
+/// with the destroy alone.
+final class OwnershipOptimizer: ScopePass {
+  /// The continuations each primop of the scope is scheduled in.
+  private var homes = [PrimOp: Set<Continuation>]()
+
+  /// Only copies, destroys and loads are replaced, so the control flow of
+  /// the scope is left alone.
+  static var preservedAnalyses: PreservedAnalyses {
+    return [.scopes, .controlFlow]
+  }
+
+  func run(on scope: Scope, analyses: AnalysisManager) {
+    self.homes.removeAll()
+    let schedule = analyses.schedule(of: scope)
+    for block in schedule.blocks {
+      for primop in block.primops {
+        self.homes[primop, default: []].insert(block.parent)
+      }
+    }
+
+    let B = GIRBuilder(module: scope.module)
+    for block in schedule.blocks {
+      let cont = block.parent
+      for cleanup in cont.cleanups {
+        switch cleanup {
+        case let destroy as DestroyValueOp:
+          if !self.removeCopyDestroyPair(cont, destroy) {
+            self.forwardCopy(cont, destroy)
+          }
+        case let destroy as DestroyAddressOp:
+          self.takeLoad(cont, destroy, B)
+        default:
+          continue
+        }
+      }
+    }
+  }
+
+  /// Returns whether a primop is scheduled in the given continuation and no
+  /// other.
+  private func isLocal(_ primop: PrimOp, to cont: Continuation) -> Bool {
+    return self.homes[primop] == [cont]
+  }
+
+  /// Returns whether a primop, and every user of it, is scheduled in the
+  /// given continuation and no other.
+  private func isLocalWithUsers(
+    _ primop: PrimOp, to cont: Continuation
+  ) -> Bool {
+    return self.isLocal(primop, to: cont) && primop.users.allSatisfy { use in
+      return self.isLocal(use.user, to: cont)
+    }
+  }
+
+  /// Returns whether a use of an owned value leaves its ownership alone.
+  private func isBorrow(_ use: Operand) -> Bool {
+    switch use.user {
+    case is CopyValueOp:
+      return true
+    case let op as SwitchConstrOp:
+      return op.operands[0] === use
+    case let op as DataExtractOp:
+      return op.users.allSatisfy(self.isBorrow)
+    default:
+      return false
+    }
+  }
+
+  /// Removes a destroy from a continuation, along with its use of the value
+  /// it destroys.
+  private func remove(_ cleanup: PrimOp, from cont: Continuation) {
+    cont.removeCleanupOp(cleanup)
+    for operand in cleanup.operands {
+      operand.drop()
+    }
+  }
+
+  //     %1 = copy_value %0
+  //     <borrows of %1>
+  //     destroy_value %1
+  //
+  // ===>
+  //
+  //     <borrows of %0>
+  private func removeCopyDestroyPair(
+    _ cont: Continuation, _ destroy: DestroyValueOp
+  ) -> Bool {
+    guard
+      let copy = destroy.value.value as? CopyValueOp,
+      self.isLocalWithUsers(copy, to: cont),
+      copy.users.allSatisfy({ $0.user === destroy || self.isBorrow($0) })
+    else {
+      return false
+    }
+    self.remove(destroy, from: cont)
+    copy.replaceAllUsesWith(copy.value.value)
+    copy.value.drop()
+    return true
+  }
+
+  //     %1 = copy_value %0
+  //     <uses of %1>
+  //     destroy_value %0
+  //
+  // ===>
+  //
+  //     <uses of %0>
+  private func forwardCopy(_ cont: Continuation, _ destroy: DestroyValueOp) {
+    let value = destroy.value.value
+    for use in value.users {
+      guard
+        let copy = use.user as? CopyValueOp,
+        self.isLocalWithUsers(copy, to: cont)
+      else {
+        continue
+      }
+      self.remove(destroy, from: cont)
+      copy.replaceAllUsesWith(value)
+      copy.value.drop()
+      return
+    }
+  }
+
+  //     %1 = load [copy] %0
+  //     destroy_address %0
+  //
+  // ===>
+  //
+  //     %1 = load [take] %0
+  private func takeLoad(
+    _ cont: Continuation, _ destroy: DestroyAddressOp, _ B: GIRBuilder
+  ) {
+    let address = destroy.value
+    let users = Array(address.users)
+    guard
+      users.count == 2,
+      let load = users.first(where: { $0.user !== destroy })?.user as? LoadOp,
+      load.ownership == .copy,
+      self.isLocalWithUsers(load, to: cont)
+    else {
+      return
+    }
+    self.remove(destroy, from: cont)
+    load.replaceAllUsesWith(B.createLoad(address, .take))
+    load.operands[0].drop()
+  }
+}
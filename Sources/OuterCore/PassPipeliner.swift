@@ -5,6 +5,7 @@
 /// This project is released under the MIT license, a copy of which is
 /// available in the repository.
 
+import Foundation
 import Seismography
 
 /// Implements a pass manager, pipeliner, and executor for a set of
@@ -22,6 +23,10 @@ public final class PassPipeliner {
   public let module: GIRModule
   public private(set) var stages: [String]
   public private(set) var passes: [String: [OptimizerPass.Type]]
+  /// The most threads scope passes run on.
+  public let threads: Int
+  /// The analyses cached between passes.
+  public let analyses: AnalysisManager
   private var frozen: Bool = false
 
   public final class Builder {
@@ -37,11 +42,16 @@ public final class PassPipeliner {
 
   /// Initializes a new, empty pipeliner.
   ///
-  /// - Parameter module: The module the pipeliner will run over.
-  public init(module: GIRModule) {
+  /// - Parameters:
+  ///   - module: The module the pipeliner will run over.
+  ///   - threads: The most threads to run scope passes on.  Defaults to a
+  ///              single thread.
+  public init(module: GIRModule, threads: Int = 1) {
     self.module = module
     self.stages = []
     self.passes = [:]
+    self.threads = max(threads, 1)
+    self.analyses = AnalysisManager(module: module)
   }
 
   /// Appends a stage to the pipeliner.
@@ -74,6 +84,13 @@ public final class PassPipeliner {
   /// local passes have run on all local scopes and all intervening module
   /// passes have been run.
   ///
+  /// Scopes are distributed across up to `threads` workers, each with its
+  /// own instances of the local passes.  Module passes always run alone.
+  ///
+  /// Analyses are cached across passes, and after each pass those it does
+  /// not preserve are discarded.  The module may have changed since the last
+  /// execution, so execution starts without any cached analyses.
+  ///
   /// The same pipeline may be repeatedly re-executed, but pipeline execution
   /// is not re-entrancy safe.
   public func execute() {
@@ -82,22 +99,23 @@ public final class PassPipeliner {
     self.frozen = true
     defer { self.frozen = false }
 
+    self.analyses.invalidateAll()
     for stage in self.stages {
       let passTypes = self.passes[stage, default: []]
       guard !passTypes.isEmpty else {
         continue
       }
 
-      var scopePasses = [ScopePass]()
+      var scopePasses = [ScopePass.Type]()
       for type in self.passes[stage, default: []] {
-        let pass = type.init()
-        if let contPass = pass as? ScopePass {
+        if let contPass = type as? ScopePass.Type {
           scopePasses.append(contPass)
-        } else if let modPass = pass as? ModulePass {
+        } else if let modPass = type as? ModulePass.Type {
           self.runScopePasses(scopePasses)
           scopePasses.removeAll()
 
-          modPass.run(on: self.module)
+          modPass.init().run(on: self.module)
+          self.analyses.invalidateAll(preserving: modPass.preservedAnalyses)
         } else {
           fatalError("Pass must be Function or Module pass")
         }
@@ -107,31 +125,60 @@ public final class PassPipeliner {
     }
   }
 
-  private func runScopePasses(_ passes: [ScopePass]) {
-    struct WorklistEntry {
-      let scope: Scope
-      var index: Int
+  private func runScopePasses(_ passTypes: [ScopePass.Type]) {
+    guard !passTypes.isEmpty else {
+      return
     }
 
-    var worklist = [WorklistEntry]()
-    worklist.reserveCapacity(self.module.continuations.count)
-    for scope in self.module.topLevelScopes {
-      worklist.append(WorklistEntry(scope: scope, index: 0))
+    // Scopes are discovered before any worker starts, after which each
+    // worker only touches the analyses of the scopes it runs on.
+    let scopes = self.analyses.topLevelScopes
+    defer {
+      // Scope passes may change the partition of the module into scopes,
+      // but only once every scope has been visited can it be recomputed.
+      let preserved = passTypes.reduce(PreservedAnalyses.all) { kept, pass in
+        return kept.intersection(pass.preservedAnalyses)
+      }
+      if !preserved.contains(.scopes) {
+        self.analyses.invalidateAll(preserving: preserved)
+      }
     }
 
-    while !worklist.isEmpty {
-      let tailIdx = worklist.count - 1
-      let pipelineIdx = worklist[tailIdx].index
-      let scope = worklist[tailIdx].scope
+    let workers = min(self.threads, scopes.count)
+    guard workers > 1 else {
+      let passes = passTypes.map { $0.init() }
+      for scope in scopes.reversed() {
+        self.run(passes, on: scope)
+      }
+      return
+    }
 
-      if worklist[tailIdx].index >= passes.count {
-        // All passes did already run for the function. Pop it off the worklist.
-        _ = worklist.popLast()
-        continue
+    // Scope passes keep local state, so every worker needs its own
+    // instances.  Workers take the next scope as they finish one, as scopes
+    // vary widely in size.
+    let lock = NSLock()
+    var nextScope = 0
+    DispatchQueue.concurrentPerform(iterations: workers) { _ in
+      let passes = passTypes.map { $0.init() }
+      while true {
+        lock.lock()
+        let index = nextScope
+        nextScope += 1
+        lock.unlock()
+
+        guard index < scopes.count else {
+          return
+        }
+        self.run(passes, on: scopes[index])
       }
+    }
+  }
 
-      passes[pipelineIdx].run(on: scope)
-      worklist[tailIdx].index += 1
+  private func run(_ passes: [ScopePass], on scope: Scope) {
+    for pass in passes {
+      pass.run(on: scope, analyses: self.analyses)
+      self.analyses.invalidate(scope,
+                               preserving: type(of: pass).preservedAnalyses)
     }
   }
 }
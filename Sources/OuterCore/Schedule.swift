@@ -41,12 +41,17 @@ public final class Schedule {
   public let tag: Tag
   public internal(set) var blocks: [Block] = []
   var indices: [Continuation: Int] = [:]
-  public init(_ scope: Scope, _ tag: Tag) {
+  public convenience init(_ scope: Scope, _ tag: Tag) {
+    self.init(scope, tag, order: Array(scope.reversePostOrder))
+  }
+
+  /// Schedules a scope whose reverse post-order is already known.
+  init(_ scope: Scope, _ tag: Tag, order: [Continuation]) {
     self.scope = scope
     self.tag = tag
 
     var i = 0
-    for n in scope.reversePostOrder {
+    for n in order {
       defer { i += 1 }
       self.blocks.append(Block(n, [], i))
       self.indices[n] = i
@@ -18,10 +18,12 @@ final class SimplifyCFG: ScopePass {
   var loopHeaders = Set<Continuation>()
   var jumpThreadedBlocks = [Continuation: Int]()
 
-  func run(on scope: Scope) {
+  func run(on scope: Scope, analyses: AnalysisManager) {
     for cont in scope.continuations {
       self.addToWorklist(cont)
     }
+    // Merging only removes continuations, so this never gains members.
+    let localContinuations = Set(scope.continuations)
 
     while let cont = self.popWorklist() {
       guard !self.removeDeadContinuationIfNecessary(scope, cont) else {
@@ -37,7 +39,10 @@ final class SimplifyCFG: ScopePass {
         // swiftlint:disable force_cast
         let op = terminalOp as! ApplyOp
         switch op.callee {
-        case let funcRef as FunctionRefOp:
+        // Only merge continuations of this scope; scopes may be simplified
+        // concurrently.
+        case let funcRef as FunctionRefOp
+          where localContinuations.contains(funcRef.function):
           return self.simplifyBranchBlock(scope, cont, op, funcRef)
         default:
           break
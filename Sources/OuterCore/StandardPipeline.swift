@@ -0,0 +1,56 @@
+/// StandardPipeline.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Seismography
+
+extension PassPipeliner {
+  /// Every optimizer pass, in the order the standard pipeline first runs
+  /// them.
+  public static let registeredPasses: [OptimizerPass.Type] = [
+    SimplifyCFG.self,
+    GlobalValueNumbering.self,
+    OwnershipOptimizer.self,
+    Inliner.self,
+  ]
+
+  /// Returns the registered pass with the given type name, such as
+  /// `SimplifyCFG`.
+  public static func pass(named name: String) -> OptimizerPass.Type? {
+    return self.registeredPasses.first { type in
+      return String(describing: type) == name
+    }
+  }
+
+  /// Adds the stages of the standard GraphIR pipeline for an optimization
+  /// level.
+  ///
+  /// At `-O0` no passes run, so the GraphIR that reaches IRGen is exactly
+  /// what GIRGen produced.  Every other level first cleans up the control
+  /// flow GIRGen leaves behind for pattern matching, so later passes see
+  /// merged continuations, then merges redundant pure primops and removes
+  /// redundant copies and destroys.  From `-O2`, small functions are then
+  /// inlined into their callers and the result simplified again.
+  public func addStandardStages(for level: OptimizationLevel) {
+    guard level > .none else {
+      return
+    }
+    self.addStage("Simplification") { p in
+      p.add(SimplifyCFG.self)
+      p.add(GlobalValueNumbering.self)
+      p.add(OwnershipOptimizer.self)
+    }
+    guard level >= .default else {
+      return
+    }
+    self.addStage("Inlining") { p in
+      p.add(Inliner.self)
+      p.add(SimplifyCFG.self)
+      p.add(GlobalValueNumbering.self)
+      p.add(OwnershipOptimizer.self)
+    }
+  }
+}
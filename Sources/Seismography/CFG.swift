@@ -5,6 +5,8 @@
 /// This project is released under the MIT license, a copy of which is
 /// available in the repository.
 
+import Foundation
+
 public final class Successor {
   /// The primop that contains this successor.
   public private(set) var containingInst: PrimOp?
@@ -45,21 +47,27 @@ public final class Successor {
 
     // If we were already pointing to a basic block, remove ourself from its
     // predecessor list.
-    if self.successor != nil {
+    if let current = self.successor {
+      let lock = useListLock(for: current)
+      lock.lock()
       self.previous?.setSuccessor(self.next?.successor)
       if let next = self.next {
         next.previous = self.previous
       }
+      lock.unlock()
     }
 
     // If we have a successor, add ourself to its prev list.
     if let succ = succ {
+      let lock = useListLock(for: succ)
+      lock.lock()
       self.previous = succ.predecessorList
       self.next = succ.predecessorList
       if let next = self.next {
         next.previous = self.next
       }
       succ.predecessorList = self
+      lock.unlock()
     }
     self.successor = succ
   }
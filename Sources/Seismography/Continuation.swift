@@ -5,6 +5,7 @@
 /// This project is released under the MIT license, a copy of which is
 /// available in the repository.
 
+import Foundation
 import Moho
 
 public struct ParameterSemantics {
@@ -39,6 +40,9 @@ public final class Continuation: NominalValue, GraphNode {
   public weak var terminalOp: TerminalOp?
 
   public var hasPredecessors: Bool {
+    let lock = useListLock(for: self)
+    lock.lock()
+    defer { lock.unlock() }
     return self.predecessorList.next != nil
   }
 
@@ -50,10 +54,16 @@ public final class Continuation: NominalValue, GraphNode {
     return it.next()
   }
 
+  /// The continuations that branch to this one.
+  ///
+  /// The predecessors are collected up front, so branches may be added or
+  /// removed while iterating over them.
   public var predecessors: AnySequence<Continuation> {
-    return AnySequence { () in
-      return PredecessorIterator(self.predecessorList)
-    }
+    let lock = useListLock(for: self)
+    lock.lock()
+    defer { lock.unlock() }
+    return AnySequence(Array(IteratorSequence(
+      PredecessorIterator(self.predecessorList))))
   }
 
   public var successors: [Continuation] {
@@ -91,6 +101,12 @@ public final class Continuation: NominalValue, GraphNode {
     self.cleanups.append(cleanup)
   }
 
+  /// Removes a cleanup from this continuation.  The operands of the cleanup
+  /// are left untouched.
+  public func removeCleanupOp(_ cleanup: PrimOp) {
+    self.cleanups.removeAll(where: { $0 === cleanup })
+  }
+
   @discardableResult
   public func appendIndirectReturnParameter(type: GIRType) -> Parameter {
     precondition(type.category == .address,
@@ -23,6 +23,9 @@ public final class GIRModule {
   public let typeType = TypeType.shared
   public let typeConverter: TypeConverter
   private weak var parentModule: GIRModule?
+  /// Guards the tables of this module, which optimizer passes running on
+  /// separate scopes may update concurrently.
+  private let lock = NSLock()
 
   public init(name: String = "main", parent: GIRModule?, tc: TypeConverter) {
     self.name = name
@@ -32,28 +35,38 @@ public final class GIRModule {
   }
 
   public func addContinuation(_ continuation: Continuation) {
+    self.lock.lock()
+    defer { self.lock.unlock() }
     continuations.append(continuation)
     continuationTable[keyForContinuation(continuation)] = continuation
     continuation.module = self
   }
 
   public func removeContinuation(_ continuation: Continuation) {
+    self.lock.lock()
+    defer { self.lock.unlock() }
     continuations.removeAll(where: { $0 == continuation })
     continuationTable[keyForContinuation(continuation)] = nil
     continuation.module = nil
   }
 
   public func addPrimOp(_ primOp: PrimOp) {
+    self.lock.lock()
+    defer { self.lock.unlock() }
     primops.append(primOp)
   }
 
   public func lookupContinuation(_ ref: DeclRef) -> Continuation? {
+    self.lock.lock()
+    defer { self.lock.unlock() }
     return self.continuationTable[ref]
   }
 
   public func functionType(arguments: [GIRType],
                            returnType: GIRType) -> FunctionType {
     let function = FunctionType(arguments: arguments, returnType: returnType)
+    self.lock.lock()
+    defer { self.lock.unlock() }
     return knownFunctionTypes.getOrInsert(function)
   }
 
@@ -67,6 +80,8 @@ public final class GIRModule {
       Unmanaged.passUnretained(module).toOpaque().hash(into: &hasher)
     }
     let id = hasher.finalize()
+    self.lock.lock()
+    defer { self.lock.unlock() }
     guard let existing = self.context.dataTypes[id] else {
       let data = DataType(name: name,
                           module: module,
@@ -92,6 +107,8 @@ public final class GIRModule {
     }
     2.hash(into: &hasher)
     let id = hasher.finalize()
+    self.lock.lock()
+    defer { self.lock.unlock() }
     guard let existing = self.context.dataTypes[id] else {
       let data = DataType(name: name,
                           module: module,
@@ -305,8 +305,8 @@ public final class SwitchConstrOp: TerminalOp {
     patterns: [(pattern: String, destination: FunctionRefOp)],
     default: FunctionRefOp?
   ) {
-    self.patterns = patterns
-    self.`default` = `default`
+    self.patternNames = patterns.map { $0.pattern }
+    self.hasDefault = `default` != nil
     super.init(opcode: .switchConstr, parent: parent)
 
     self.addOperands([Operand(owner: self, value: value)])
@@ -332,8 +332,27 @@ public final class SwitchConstrOp: TerminalOp {
     return operands[0].value
   }
 
-  public let patterns: [(pattern: String, destination: FunctionRefOp)]
-  public let `default`: FunctionRefOp?
+  private let patternNames: [String]
+  private let hasDefault: Bool
+
+  /// The patterns matched, and the continuation each dispatches to.
+  ///
+  /// The destinations are read from the operands, so they follow any
+  /// replacement of the operands.
+  public var patterns: [(pattern: String, destination: FunctionRefOp)] {
+    return self.patternNames.enumerated().map { (i, name) in
+      // swiftlint:disable force_cast
+      return (pattern: name,
+              destination: operands[i + 1].value as! FunctionRefOp)
+    }
+  }
+
+  public var `default`: FunctionRefOp? {
+    guard self.hasDefault else {
+      return nil
+    }
+    return operands.last!.value as? FunctionRefOp
+  }
 }
 
 public final class DataInitOp: PrimOp {
@@ -362,11 +381,9 @@ public final class DataInitOp: PrimOp {
 
 public final class DataExtractOp: PrimOp {
   public let constructor: String
-  public let dataValue: Value
 
   public init(constructor: String, value: Value, payloadType: Value) {
     self.constructor = constructor
-    self.dataValue = value
     super.init(opcode: .dataExtract, type: payloadType,
                category: payloadType.category)
     self.addOperands([
@@ -374,6 +391,10 @@ public final class DataExtractOp: PrimOp {
     ])
   }
 
+  public var dataValue: Value {
+    return operands[0].value
+  }
+
   public override var result: Value? {
     return self
   }
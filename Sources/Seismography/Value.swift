@@ -8,6 +8,24 @@
 import Foundation
 import Moho
 
+/// Guard the use-chains of values and the predecessor lists of
+/// continuations.
+///
+/// Values such as continuations and types are shared between scopes, so
+/// optimizer passes running on separate scopes may link and unlink uses of
+/// them concurrently.  Each value is guarded by one of these locks, picked
+/// by its address, so passes only wait on each other when they touch the
+/// same value or values that share a lock.  The locks are recursive because
+/// unlinking a successor updates its neighbors.
+private let useListLocks = (0..<64).map { _ in NSRecursiveLock() }
+
+/// Returns the lock that guards the uses and predecessors of a value.
+func useListLock(for value: Value) -> NSRecursiveLock {
+  // Objects are at least 16-byte aligned, so the low bits are always zero.
+  let address = UInt(bitPattern: ObjectIdentifier(value)) >> 4
+  return useListLocks[Int(address % UInt(useListLocks.count))]
+}
+
 public class Value: Hashable, ManglingEntity {
   public enum Category {
     case object
@@ -51,16 +69,26 @@ public class Value: Hashable, ManglingEntity {
   fileprivate var firstUse: Operand?
 
   public var hasUsers: Bool {
+    let lock = useListLock(for: self)
+    lock.lock()
+    defer { lock.unlock() }
     return self.firstUse != nil
   }
 
+  /// The operands that use this value.
+  ///
+  /// The uses are collected up front, so operands may be dropped or pointed
+  /// at other values while iterating over them.
   public var users: AnySequence<Operand> {
+    let lock = useListLock(for: self)
+    lock.lock()
+    defer { lock.unlock() }
     guard let first = self.firstUse else {
       return AnySequence<Operand>([])
     }
-    return AnySequence<Operand>(sequence(first: first) { use in
+    return AnySequence<Operand>(Array(sequence(first: first) { use in
       return use.nextUse
-    })
+    }))
   }
 
   public func replaceAllUsesWith(_ RHS: Value) {
@@ -129,10 +157,13 @@ public final class Operand: Hashable {
   /// designated result.
   var nextUse: Operand?
 
-  /// A back-pointer in the use-chain, required for fast patching
-  /// of use-chains.
+  /// The previous operand in the use-chain, or `nil` if this is the first
+  /// use of its value.  Required for fast patching of use-chains.
   weak var back: Operand?
 
+  /// Whether this operand is linked into the use-chain of its value.
+  private var isLinked = false
+
   /// The owner of this operand.
   /// FIXME: this could be space-compressed.
   weak var owningOp: PrimOp?
@@ -169,8 +200,6 @@ public final class Operand: Hashable {
   /// Remove this use of the operand.
   public func drop() {
     self.removeFromCurrent()
-    self.nextUse = nil
-    self.back = nil
     self.owningOp = nil
   }
 
@@ -180,21 +209,31 @@ public final class Operand: Hashable {
   }
 
   private func removeFromCurrent() {
-    guard let backPtr = self.back else {
+    let lock = useListLock(for: self.value)
+    lock.lock()
+    defer { lock.unlock() }
+    guard self.isLinked else {
       return
     }
-    self.back = self.nextUse
-    if let next = self.nextUse {
-      next.back = backPtr
+    if let previous = self.back {
+      previous.nextUse = self.nextUse
+    } else {
+      self.value.firstUse = self.nextUse
     }
+    self.nextUse?.back = self.back
+    self.nextUse = nil
+    self.back = nil
+    self.isLinked = false
   }
 
   private func insertIntoCurrent() {
-    self.back = self.value.firstUse
+    let lock = useListLock(for: self.value)
+    lock.lock()
+    defer { lock.unlock() }
+    self.back = nil
     self.nextUse = self.value.firstUse
-    if let next = self.nextUse {
-      next.back = self.nextUse
-    }
+    self.nextUse?.back = self
     self.value.firstUse = self
+    self.isLinked = true
   }
 }
@@ -0,0 +1,142 @@
+/// Measurement.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Foundation
+
+#if os(Linux)
+import Glibc
+#else
+import Darwin
+#endif
+
+/// The result of running a child process to completion.
+struct ProcessMeasurement {
+  /// The exit status of the process, or `nil` if it was killed by a signal.
+  let exitStatus: Int32?
+  /// The wall time between spawning the process and reaping it, in seconds.
+  let wallTime: TimeInterval
+  /// The peak resident set size of the process, in bytes.
+  let peakRSS: Int
+}
+
+enum MeasurementError: Error, CustomStringConvertible {
+  case spawnFailed(String, Int32)
+  case waitFailed(String, Int32)
+
+  var description: String {
+    switch self {
+    case let .spawnFailed(path, errno):
+      return "could not spawn '\(path)': \(String(cString: strerror(errno)))"
+    case let .waitFailed(path, errno):
+      return "could not wait for '\(path)': \(String(cString: strerror(errno)))"
+    }
+  }
+}
+
+/// Runs an executable to completion and reports its resource usage.
+///
+/// `Foundation.Process` does not expose the child's `rusage`, so this spawns
+/// the child directly and reaps it with `wait4`.
+///
+/// - Parameters:
+///   - path: The path to the executable.
+///   - arguments: The arguments to pass, not including the program name.
+///   - environment: Extra environment variables to set in the child.
+func measureProcess(
+  _ path: String, _ arguments: [String],
+  environment: [String: String] = [:]
+) throws -> ProcessMeasurement {
+  var env = ProcessInfo.processInfo.environment
+  for (key, value) in environment {
+    env[key] = value
+  }
+
+  let argv = ([path] + arguments).map { strdup($0) } + [nil]
+  let envp = env.map { strdup("\($0.key)=\($0.value)") } + [nil]
+  defer {
+    argv.forEach { free($0) }
+    envp.forEach { free($0) }
+  }
+
+  let start = DispatchTime.now()
+  var pid = pid_t()
+  let spawnResult = posix_spawn(&pid, path, nil, nil, argv, envp)
+  guard spawnResult == 0 else {
+    throw MeasurementError.spawnFailed(path, spawnResult)
+  }
+
+  var status: Int32 = 0
+  var usage = rusage()
+  while wait4(pid, &status, 0, &usage) == -1 {
+    guard errno == EINTR else {
+      throw MeasurementError.waitFailed(path, errno)
+    }
+  }
+  let end = DispatchTime.now()
+
+  // WIFEXITED and WEXITSTATUS are macros and are not imported.
+  let exited = (status & 0x7f) == 0
+  let exitStatus: Int32? = exited ? (status >> 8) & 0xff : nil
+
+  #if os(Linux)
+  // Linux reports the maximum resident set size in kilobytes.
+  let peakRSS = Int(usage.ru_maxrss) * 1024
+  #else
+  let peakRSS = Int(usage.ru_maxrss)
+  #endif
+
+  let nanoseconds = end.uptimeNanoseconds - start.uptimeNanoseconds
+  return ProcessMeasurement(exitStatus: exitStatus,
+                            wallTime: TimeInterval(nanoseconds) / 1e9,
+                            peakRSS: peakRSS)
+}
+
+/// The counters written by Ferrite when `SILT_FERRITE_STATS` is set.
+struct HeapStatistics: Codable {
+  let allocations: Int
+  let deallocations: Int
+  let allocatedBytes: Int
+}
+
+/// Summary statistics over a set of samples.
+struct Statistics: Codable {
+  let min: Double
+  let max: Double
+  let mean: Double
+  let median: Double
+  let stddev: Double
+  /// The median absolute deviation from the median.  This is the noise
+  /// estimate used when comparing against a baseline, as it is far less
+  /// sensitive to the odd descheduled run than the standard deviation.
+  let mad: Double
+
+  init(_ samples: [Double]) {
+    precondition(!samples.isEmpty, "no samples to summarize")
+    let sorted = samples.sorted()
+    self.min = sorted.first!
+    self.max = sorted.last!
+    self.median = Statistics.median(sorted)
+    self.mean = sorted.reduce(0, +) / Double(sorted.count)
+    if sorted.count > 1 {
+      let squares = sorted.map { ($0 - self.mean) * ($0 - self.mean) }
+      self.stddev = (squares.reduce(0, +) / Double(sorted.count - 1))
+                      .squareRoot()
+    } else {
+      self.stddev = 0
+    }
+    let median = self.median
+    self.mad = Statistics.median(sorted.map { abs($0 - median) }.sorted())
+  }
+
+  private static func median(_ sorted: [Double]) -> Double {
+    let mid = sorted.count / 2
+    if sorted.count % 2 == 0 {
+      return (sorted[mid - 1] + sorted[mid]) / 2
+    }
+    return sorted[mid]
+  }
+}
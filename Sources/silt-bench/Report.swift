@@ -0,0 +1,150 @@
+/// Report.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Foundation
+
+/// The measurements taken for a single workload.
+struct WorkloadResult: Codable {
+  /// The name of the workload, taken from its file name.
+  let name: String
+  /// The number of timed runs.
+  let runs: Int
+  /// The time taken by `silt` to compile the workload, in seconds.
+  let compileTime: Double
+  /// Wall time of each run, in seconds.
+  let wallTime: Statistics
+  /// Peak resident set size of each run, in bytes.
+  let peakRSS: Statistics
+  /// The heap counters reported by the runtime.  These are deterministic, so
+  /// a single run's worth is recorded.
+  let heap: HeapStatistics?
+  /// The raw wall times, in seconds.
+  let samples: [Double]
+}
+
+/// A complete benchmark report, as written by `--output` and read back by
+/// `--baseline`.
+struct BenchmarkReport: Codable {
+  let date: Date
+  /// The `-O` level the workloads were compiled at, if one was given.
+  let optimizationLevel: String?
+  let results: [WorkloadResult]
+
+  func write(to url: URL) throws {
+    let encoder = JSONEncoder()
+    encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+    encoder.dateEncodingStrategy = .iso8601
+    try encoder.encode(self).write(to: url)
+  }
+
+  static func read(from url: URL) throws -> BenchmarkReport {
+    let decoder = JSONDecoder()
+    decoder.dateDecodingStrategy = .iso8601
+    return try decoder.decode(BenchmarkReport.self, from: Data(contentsOf: url))
+  }
+}
+
+/// The outcome of comparing one metric against a baseline.
+enum Verdict: String {
+  case improved
+  case unchanged
+  case regressed
+}
+
+/// A metric that changed between the baseline and the current run.
+struct Comparison {
+  let workload: String
+  let metric: String
+  let baseline: Double
+  let current: Double
+  let verdict: Verdict
+
+  var relativeChange: Double {
+    guard baseline != 0 else { return 0 }
+    return (current - baseline) / baseline
+  }
+}
+
+/// Compares reports metric-by-metric.
+///
+/// Timing is noisy, so a change in median wall time only counts if it is
+/// larger than both the relative `threshold` and `noiseFactor` times the
+/// combined median absolute deviation of the two runs.  Peak RSS is compared
+/// against the relative threshold alone.  Allocation counts are
+/// deterministic, so any increase is a regression.
+struct BaselineComparator {
+  let threshold: Double
+  let noiseFactor: Double
+
+  func compare(_ baseline: BenchmarkReport,
+               _ current: BenchmarkReport) -> [Comparison] {
+    var baselineByName = [String: WorkloadResult]()
+    for result in baseline.results {
+      baselineByName[result.name] = result
+    }
+
+    var comparisons = [Comparison]()
+    for result in current.results {
+      guard let base = baselineByName[result.name] else {
+        continue
+      }
+
+      let noise = self.noiseFactor
+                * (base.wallTime.mad * base.wallTime.mad
+                   + result.wallTime.mad * result.wallTime.mad).squareRoot()
+      comparisons.append(self.compare(result.name, "wall-time",
+                                      base.wallTime.median,
+                                      result.wallTime.median,
+                                      noise: noise))
+      comparisons.append(self.compare(result.name, "peak-rss",
+                                      base.peakRSS.median,
+                                      result.peakRSS.median,
+                                      noise: 0))
+
+      if let baseHeap = base.heap, let heap = result.heap {
+        comparisons.append(self.compareExact(result.name, "allocations",
+                                             baseHeap.allocations,
+                                             heap.allocations))
+        comparisons.append(self.compareExact(result.name, "allocated-bytes",
+                                             baseHeap.allocatedBytes,
+                                             heap.allocatedBytes))
+      }
+    }
+    return comparisons
+  }
+
+  private func compare(_ workload: String, _ metric: String,
+                       _ baseline: Double, _ current: Double,
+                       noise: Double) -> Comparison {
+    let delta = current - baseline
+    let significant = abs(delta) > baseline * self.threshold
+                   && abs(delta) > noise
+    let verdict: Verdict
+    if !significant {
+      verdict = .unchanged
+    } else {
+      verdict = delta > 0 ? .regressed : .improved
+    }
+    return Comparison(workload: workload, metric: metric,
+                      baseline: baseline, current: current, verdict: verdict)
+  }
+
+  private func compareExact(_ workload: String, _ metric: String,
+                            _ baseline: Int, _ current: Int) -> Comparison {
+    let verdict: Verdict
+    if current > baseline {
+      verdict = .regressed
+    } else if current < baseline {
+      verdict = .improved
+    } else {
+      verdict = .unchanged
+    }
+    return Comparison(workload: workload, metric: metric,
+                      baseline: Double(baseline), current: Double(current),
+                      verdict: verdict)
+  }
+}
@@ -0,0 +1,290 @@
+/// main.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Foundation
+import Basic
+import SPMUtility
+import Symbolic
+
+#if os(Linux)
+import Glibc
+#endif
+
+let cli = ArgumentParser(commandName: "silt-bench", usage: "",
+                         overview: "Run the silt end-to-end benchmarks")
+
+let siltExe =
+  cli.add(option: "--silt", kind: String.self,
+          usage: """
+                 The path to the `silt` executable. \
+                 Defaults to the executable next to `silt-bench`.
+                 """)
+
+let workloadDir =
+  cli.add(option: "--workloads", shortName: "-d", kind: String.self,
+          usage: """
+                 The directory containing the workloads to run. \
+                 Defaults to Benchmarks/Workloads.
+                 """)
+
+let optimizationLevel =
+  cli.add(option: "--optimize", shortName: "-O", kind: String.self,
+          usage: """
+                 The optimization level (0-3) to compile the workloads at. \
+                 Defaults to silt's own default.
+                 """)
+
+let runCount =
+  cli.add(option: "--runs", shortName: "-n", kind: Int.self,
+          usage: "The number of timed runs per workload. Defaults to 10.")
+
+let warmupCount =
+  cli.add(option: "--warmup", kind: Int.self,
+          usage: "The number of untimed runs per workload. Defaults to 1.")
+
+let outputPath =
+  cli.add(option: "--output", shortName: "-o", kind: String.self,
+          usage: "Write the results as JSON to this file.")
+
+let baselinePath =
+  cli.add(option: "--baseline", kind: String.self,
+          usage: """
+                 Compare the results against a report previously written \
+                 with --output, and fail if any workload regressed.
+                 """)
+
+let thresholdArg =
+  cli.add(option: "--threshold", kind: Double.self,
+          usage: """
+                 The relative change, as a fraction, below which a difference \
+                 is never reported. Defaults to 0.05.
+                 """)
+
+let noiseFactorArg =
+  cli.add(option: "--noise-factor", kind: Double.self,
+          usage: """
+                 How many combined median absolute deviations a timing \
+                 change must exceed to be reported. Defaults to 3.
+                 """)
+
+let filterRegexes =
+  cli.add(option: "--filter", kind: [String].self, strategy: .oneByOne,
+          usage: """
+                 A list of regexes to filter the workloads. If a workload \
+                 matches any of the provided filters, it's run.
+                 """)
+
+/// Finds the named executable relative to the location of the `silt-bench`
+/// executable.
+func findAdjacentBinary(_ name: String) -> URL? {
+  guard let path = SymbolInfo(address: #dsohandle)?.filename else { return nil }
+  let url = path.deletingLastPathComponent().appendingPathComponent(name)
+  guard FileManager.default.fileExists(atPath: url.path) else { return nil }
+  return url
+}
+
+/// Compiles and runs a single workload, returning its measurements.
+func runWorkload(
+  _ workload: URL, silt: URL, level: String?, scratch: URL, runs: Int,
+  warmup: Int
+) throws -> WorkloadResult {
+  let name = workload.deletingPathExtension().lastPathComponent
+  let executable = scratch.appendingPathComponent(name)
+  let statsFile = scratch.appendingPathComponent(name + ".stats.json")
+
+  var arguments = [workload.path, "-o", executable.path]
+  if let level = level {
+    arguments += ["-O", level]
+  }
+  let compile = try measureProcess(silt.path, arguments)
+  guard compile.exitStatus == 0 else {
+    throw BenchError.compileFailed(name)
+  }
+
+  let environment = ["SILT_FERRITE_STATS": statsFile.path]
+  var wallTimes = [Double]()
+  var peakRSSes = [Double]()
+  for iteration in 0..<(warmup + runs) {
+    let run = try measureProcess(executable.path, [],
+                                 environment: environment)
+    guard run.exitStatus == 0 else {
+      throw BenchError.runFailed(name, run.exitStatus)
+    }
+    guard iteration >= warmup else {
+      continue
+    }
+    wallTimes.append(run.wallTime)
+    peakRSSes.append(Double(run.peakRSS))
+  }
+
+  let heap = (try? Data(contentsOf: statsFile)).flatMap {
+    try? JSONDecoder().decode(HeapStatistics.self, from: $0)
+  }
+  return WorkloadResult(name: name, runs: runs,
+                        compileTime: compile.wallTime,
+                        wallTime: Statistics(wallTimes),
+                        peakRSS: Statistics(peakRSSes),
+                        heap: heap, samples: wallTimes)
+}
+
+enum BenchError: Error, CustomStringConvertible {
+  case compileFailed(String)
+  case runFailed(String, Int32?)
+
+  var description: String {
+    switch self {
+    case let .compileFailed(name):
+      return "failed to compile workload '\(name)'"
+    case let .runFailed(name, status?):
+      return "workload '\(name)' exited with status \(status)"
+    case let .runFailed(name, nil):
+      return "workload '\(name)' was terminated by a signal"
+    }
+  }
+}
+
+func run() -> Int32 {
+  let args = Array(CommandLine.arguments.dropFirst())
+  guard let result = try? cli.parse(args) else {
+    cli.printUsage(on: Basic.stdoutStream)
+    return EXIT_FAILURE
+  }
+
+  let siltURL =
+    result.get(siltExe).map(URL.init(fileURLWithPath:))
+      ?? findAdjacentBinary("silt")
+  guard let silt = siltURL else {
+    print("error: unable to infer silt binary path")
+    return EXIT_FAILURE
+  }
+
+  let level = result.get(optimizationLevel)
+  if let level = level, !["0", "1", "2", "3"].contains(level) {
+    print("error: unknown optimization level '\(level)'")
+    return EXIT_FAILURE
+  }
+  let runs = max(1, result.get(runCount) ?? 10)
+  let warmup = max(0, result.get(warmupCount) ?? 1)
+  let directory = URL(fileURLWithPath: result.get(workloadDir)
+                                         ?? "Benchmarks/Workloads")
+
+  let workloads: [URL]
+  let regexes: [NSRegularExpression]
+  do {
+    regexes = try (result.get(filterRegexes) ?? []).map {
+      try NSRegularExpression(pattern: $0)
+    }
+    workloads = try FileManager.default
+      .contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)
+      .filter { $0.pathExtension == "silt" }
+      .filter { url in
+        let path = url.path
+        let range = NSRange(location: 0, length: path.utf16.count)
+        return regexes.isEmpty || regexes.contains {
+          $0.firstMatch(in: path, range: range) != nil
+        }
+      }
+      .sorted { $0.lastPathComponent < $1.lastPathComponent }
+  } catch {
+    print("error: \(error)")
+    return EXIT_FAILURE
+  }
+
+  let scratch = FileManager.default.temporaryDirectory
+    .appendingPathComponent("silt-bench-\(getpid())")
+  do {
+    try FileManager.default.createDirectory(at: scratch,
+                                            withIntermediateDirectories: true)
+  } catch {
+    print("error: \(error)")
+    return EXIT_FAILURE
+  }
+  defer { try? FileManager.default.removeItem(at: scratch) }
+
+  var status = EXIT_SUCCESS
+  var results = [WorkloadResult]()
+  for workload in workloads {
+    do {
+      let measured = try runWorkload(workload, silt: silt, level: level,
+                                     scratch: scratch, runs: runs,
+                                     warmup: warmup)
+      results.append(measured)
+      let allocations = measured.heap.map { "\($0.allocations)" } ?? "N/A"
+      print("""
+            \(measured.name): \
+            median \(measured.wallTime.median.formatted) \
+            (mad \(measured.wallTime.mad.formatted)), \
+            peak RSS \(Int(measured.peakRSS.median) / 1024)KiB, \
+            \(allocations) allocations
+            """)
+    } catch {
+      print("error: \(error)")
+      status = EXIT_FAILURE
+    }
+  }
+
+  let report = BenchmarkReport(date: Date(), optimizationLevel: level,
+                               results: results)
+  if let path = result.get(outputPath) {
+    do {
+      try report.write(to: URL(fileURLWithPath: path))
+    } catch {
+      print("error: could not write report: \(error)")
+      return EXIT_FAILURE
+    }
+  }
+
+  guard let baseline = result.get(baselinePath) else {
+    return status
+  }
+
+  let comparator = BaselineComparator(
+    threshold: result.get(thresholdArg) ?? 0.05,
+    noiseFactor: result.get(noiseFactorArg) ?? 3.0)
+  let comparisons: [Comparison]
+  do {
+    let baselineReport = try BenchmarkReport.read(
+      from: URL(fileURLWithPath: baseline))
+    comparisons = comparator.compare(baselineReport, report)
+    if baselineReport.optimizationLevel != level {
+      print("""
+            warning: the baseline was compiled at \
+            -O\(baselineReport.optimizationLevel ?? "<default>"), \
+            not -O\(level ?? "<default>")
+            """)
+    }
+  } catch {
+    print("error: could not read baseline: \(error)")
+    return EXIT_FAILURE
+  }
+
+  for comparison in comparisons where comparison.verdict != .unchanged {
+    let percent = String(format: "%+.1f%%", comparison.relativeChange * 100)
+    print("""
+          \(comparison.verdict.rawValue): \(comparison.workload) \
+          \(comparison.metric) \(percent)
+          """)
+    if comparison.verdict == .regressed {
+      status = EXIT_FAILURE
+    }
+  }
+  return status
+}
+
+extension Double {
+  /// Formats a duration in seconds at the most appropriate unit.
+  var formatted: String {
+    if self >= 1.0 {
+      return String(format: "%.2fs", self)
+    } else if self >= 0.001 {
+      return String(format: "%.2fms", self * 1_000)
+    }
+    return String(format: "%.2fµs", self * 1_000_000)
+  }
+}
+
+exit(run())
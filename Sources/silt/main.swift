@@ -14,6 +14,8 @@ case "demangle":
   SiltDemangleTool(Array(args.dropFirst())).run()
 case "optimize":
   SiltOptimizeTool(Array(args.dropFirst())).run()
+case "run":
+  SiltFrontendTool(args: ["--run"] + args.dropFirst()).run()
 default:
   SiltFrontendTool(args: args).run()
 }
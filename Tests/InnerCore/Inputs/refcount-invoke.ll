@@ -0,0 +1,20 @@
+declare i8* @silt_retain(i8*)
+declare void @silt_release(i8*)
+declare void @mayRelease()
+declare i32 @personality(...)
+
+define void @invoke(i8* %object) personality i32 (...)* @personality {
+entry:
+  %retained = call i8* @silt_retain(i8* %object)
+  invoke void @mayRelease()
+          to label %normal unwind label %unwind
+
+normal:
+  call void @silt_release(i8* %object)
+  ret void
+
+unwind:
+  %exception = landingpad { i8*, i32 } cleanup
+  call void @silt_release(i8* %object)
+  resume { i8*, i32 } %exception
+}
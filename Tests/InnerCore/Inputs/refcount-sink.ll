@@ -0,0 +1,22 @@
+declare i8* @silt_retain(i8*)
+declare void @silt_release(i8*)
+declare void @use(i8*)
+declare void @other()
+
+define void @sink(i8* %object, i1 %flag) {
+entry:
+  call void @silt_release(i8* %object)
+  br i1 %flag, label %again, label %done
+
+again:
+  %retained = call i8* @silt_retain(i8* %object)
+  call void @use(i8* %retained)
+  br label %exit
+
+done:
+  call void @other()
+  br label %exit
+
+exit:
+  ret void
+}
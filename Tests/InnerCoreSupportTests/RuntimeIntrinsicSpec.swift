@@ -0,0 +1,46 @@
+/// RuntimeIntrinsicSpec.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+@testable import InnerCore
+import FileCheck
+import LLVM
+import XCTest
+
+class RuntimeIntrinsicSpec: XCTestCase {
+  func testDeclarationAttributes() {
+    XCTAssert(fileCheckOutput(of: .stderr, withPrefixes: ["DECL"]) {
+      let module = Module(name: "RuntimeIntrinsicSpec")
+      let builder = IRBuilder(module: module)
+      let intrinsics: [RuntimeIntrinsic] = [
+        .alloc, .dealloc, .retain, .copyValue,
+      ]
+      for intrinsic in intrinsics {
+        let fn = builder.addFunction(intrinsic.rawValue, type: intrinsic.type)
+        intrinsic.addAttributes(to: fn.asLLVM())
+      }
+      // DECL: declare noalias nonnull i8* @silt_alloc(i8*, i64, i64) [[ALLOC:#[0-9]+]]
+      // DECL: declare void @silt_dealloc(i8*{{( allocptr)?}}, i64, i64) [[DEALLOC:#[0-9]+]]
+      // DECL: declare i8* @silt_retain(i8* returned) [[RETAIN:#[0-9]+]]
+      // DECL: declare noalias nonnull i8* @silt_copyValue(i8*) [[COPY:#[0-9]+]]
+
+      // Allocation and deallocation pair up through their family.  Versions
+      // of LLVM that know `allockind`, `nofree` or `willreturn` also get
+      // those.
+      // DECL-DAG: attributes [[ALLOC]] = { {{(.*allocsize\(1\).*nounwind|.*nounwind.*allocsize\(1\))}}{{.*}} "alloc-family"="silt" }
+      // DECL-DAG: attributes [[DEALLOC]] = { {{.*}}nounwind{{.*}} "alloc-family"="silt" }
+      // DECL-DAG: attributes [[RETAIN]] = { argmemonly {{(nofree )?}}nounwind{{( willreturn)?}} }
+      // DECL-DAG: attributes [[COPY]] = { nounwind }
+      module.dump()
+    })
+  }
+
+  #if !(os(macOS) || os(iOS) || os(watchOS) || os(tvOS))
+  static var allTests = testCase([
+    ("testDeclarationAttributes", testDeclarationAttributes),
+  ])
+  #endif
+}
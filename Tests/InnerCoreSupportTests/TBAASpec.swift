@@ -0,0 +1,78 @@
+/// TBAASpec.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+@testable import InnerCore
+import FileCheck
+import Lithosphere
+import LLVM
+import Mantle
+import Seismography
+import XCTest
+
+class TBAASpec: XCTestCase {
+  func testAccessTags() {
+    XCTAssert(fileCheckOutput(of: .stderr, withPrefixes: ["TBAA"]) {
+      let tc = TypeChecker<CheckPhaseState>(CheckPhaseState(),
+                                            DiagnosticEngine())
+      let girModule = GIRModule(name: "tbaa", parent: nil,
+                                tc: TypeConverter(tc))
+      let IGM = IRGenModule(module: girModule)
+
+      let pairTy = StructType(elementTypes: [IntType.int32, IntType.int32])
+      let fty = LLVM.FunctionType([
+        PointerType(pointee: PointerType.toVoid),
+        PointerType(pointee: IntType.int32),
+        PointerType(pointee: pairTy),
+        PointerType(pointee: IGM.sizeTy),
+      ], VoidType())
+      let fn = IGM.B.addFunction("accesses", type: fty)
+      let IGF = IRGenFunction(IGM, fn, fty)
+
+      // TBAA-LABEL: define void @accesses(
+      // TBAA: load i8*, i8** %0{{.*}}, !tbaa [[POINTER:![0-9]+]]
+      let pointer = Address(fn.parameter(at: 0)!, IGM.getPointerAlignment(),
+                            PointerType.toVoid)
+      _ = IGF.emitLoad(pointer)
+
+      // TBAA: [[INT:%[0-9]+]] = load i32, i32* %1{{.*}}, !tbaa [[I32:![0-9]+]]
+      let integer = Address(fn.parameter(at: 1)!, Alignment(4), IntType.int32)
+      let value = IGF.emitLoad(integer)
+
+      // Aggregates, and storage accessed as a payload, may hold anything.
+      // TBAA: load { i32, i32 }, { i32, i32 }* %2{{.*}}, !tbaa [[VALUE:![0-9]+]]
+      // TBAA: store i32 [[INT]], i32* %1{{.*}}, !tbaa [[VALUE]]
+      let pair = Address(fn.parameter(at: 2)!, Alignment(4), pairTy)
+      _ = IGF.emitLoad(pair)
+      IGF.emitStore(value, to: integer, as: .value)
+
+      // TBAA: load i64, i64* %3{{.*}}, !tbaa [[METADATA:![0-9]+]], !invariant.load [[EMPTY:![0-9]+]]
+      _ = IGF.emitMetadataLoad(fn.parameter(at: 3)!, type: IGM.sizeTy,
+                               alignment: IGM.getPointerAlignment(),
+                               name: "offset")
+      IGF.B.buildRetVoid()
+
+      // Every class but metadata descends from silt.value.
+      // TBAA: [[POINTER]] = !{[[POINTER_TY:![0-9]+]], {{![0-9]+}}, i64 0}
+      // TBAA: [[POINTER_TY]] = !{!"silt.pointer", [[VALUE_TY:![0-9]+]], i64 0}
+      // TBAA: [[VALUE_TY]] = !{!"silt.value", [[ROOT:![0-9]+]], i64 0}
+      // TBAA: [[ROOT]] = !{!"silt"}
+      // TBAA: [[I32]] = !{[[I32_TY:![0-9]+]], {{![0-9]+}}, i64 0}
+      // TBAA: [[I32_TY]] = !{!"silt.i32", [[VALUE_TY]], i64 0}
+      // TBAA: [[VALUE]] = !{[[VALUE_TY]], [[VALUE_TY]], i64 0}
+      // TBAA: [[METADATA]] = !{[[METADATA_TY:![0-9]+]], {{![0-9]+}}, i64 0}
+      // TBAA: [[METADATA_TY]] = !{!"silt.metadata", [[ROOT]], i64 0}
+      // TBAA: [[EMPTY]] = !{}
+      IGM.module.dump()
+    })
+  }
+
+  #if !(os(macOS) || os(iOS) || os(watchOS) || os(tvOS))
+  static var allTests = testCase([
+    ("testAccessTags", testAccessTags),
+  ])
+  #endif
+}
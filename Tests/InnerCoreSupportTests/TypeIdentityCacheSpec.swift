@@ -0,0 +1,63 @@
+/// TypeIdentityCacheSpec.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+@testable import InnerCore
+import Seismography
+import XCTest
+
+class TypeIdentityCacheSpec: XCTestCase {
+  func testEntriesAreComputedOnce() {
+    let statistics = IRGenStatistics()
+    let cache = TypeIdentityCache<Int>(statistics, \.typeInfo)
+    var computed = 0
+
+    let first = cache.entry(for: TypeType.shared) { computed += 1; return 1 }
+    let second = cache.entry(for: TypeType.shared) { computed += 1; return 2 }
+    XCTAssertEqual(1, first)
+    XCTAssertEqual(1, second)
+    XCTAssertEqual(1, computed)
+
+    // A different type gets an entry of its own.
+    let bottom = cache.entry(for: BottomType.shared) { computed += 1; return 3 }
+    XCTAssertEqual(3, bottom)
+    XCTAssertEqual(2, computed)
+
+    XCTAssertEqual(1, statistics.typeInfo.hits)
+    XCTAssertEqual(2, statistics.typeInfo.misses)
+    XCTAssertEqual(3, statistics.typeInfo.lookups)
+    XCTAssertEqual(1.0 / 3.0, statistics.typeInfo.hitRate, accuracy: 1e-9)
+
+    // Only the cache's own counter moves.
+    XCTAssertEqual(0, statistics.mangledNames.lookups)
+    XCTAssertEqual(0, statistics.typeMetadata.lookups)
+    XCTAssertEqual(0, statistics.typeMetadata.hitRate)
+  }
+
+  func testComputingAnEntryMayLookUpAnother() {
+    let statistics = IRGenStatistics()
+    let cache = TypeIdentityCache<String>(statistics, \.mangledNames)
+
+    let outer = cache.entry(for: TypeType.shared) {
+      let inner = cache.entry(for: BottomType.shared) { "B" }
+      return "T" + inner
+    }
+    XCTAssertEqual("TB", outer)
+    XCTAssertEqual("B", cache.entry(for: BottomType.shared) { "X" })
+    XCTAssertEqual("TB", cache.entry(for: TypeType.shared) { "X" })
+
+    XCTAssertEqual(2, statistics.mangledNames.hits)
+    XCTAssertEqual(2, statistics.mangledNames.misses)
+  }
+
+  #if !(os(macOS) || os(iOS) || os(watchOS) || os(tvOS))
+  static var allTests = testCase([
+    ("testEntriesAreComputedOnce", testEntriesAreComputedOnce),
+    ("testComputingAnEntryMayLookUpAnother",
+     testComputingAnEntryMayLookUpAnother),
+  ])
+  #endif
+}
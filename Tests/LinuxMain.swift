@@ -7,9 +7,16 @@
 
 import XCTest
 @testable import InnerCoreSupportTests
+@testable import OuterCoreTests
+@testable import SeismographyTests
 
 #if !os(macOS)
 XCTMain([
-  BitVectorSpec.allTests
+  AnalysisManagerSpec.allTests,
+  BitVectorSpec.allTests,
+  RuntimeIntrinsicSpec.allTests,
+  TBAASpec.allTests,
+  TypeIdentityCacheSpec.allTests,
+  UseListSpec.allTests,
 ])
 #endif
@@ -0,0 +1,98 @@
+/// AnalysisManagerSpec.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Lithosphere
+import Mantle
+import Moho
+import OuterCore
+import Seismography
+import XCTest
+
+class AnalysisManagerSpec: XCTestCase {
+  private var module: GIRModule!
+  private var builder: GIRBuilder!
+  /// Applies its second parameter to its first.
+  private var apply: ApplyOp!
+
+  override func setUp() {
+    super.setUp()
+    let tc = TypeChecker<CheckPhaseState>(CheckPhaseState(),
+                                          DiagnosticEngine())
+    self.module = GIRModule(name: "analyses", parent: nil,
+                            tc: TypeConverter(tc))
+    self.builder = GIRBuilder(module: self.module)
+    let entry = self.builder.buildContinuation(name: QualifiedName())
+    let value = entry.appendParameter(type: TypeType.shared)
+    let next = entry.appendParameter(type: TypeType.shared)
+    self.apply = self.builder.createApply(entry, next, [value])
+  }
+
+  func testAnalysesAreCached() {
+    let analyses = AnalysisManager(module: self.module)
+    let scopes = analyses.topLevelScopes
+    XCTAssertEqual(1, scopes.count)
+    XCTAssertTrue(analyses.topLevelScopes[0] === scopes[0])
+
+    let scope = scopes[0]
+    let tree = analyses.dominatorTree(of: scope)
+    let schedule = analyses.schedule(of: scope)
+    XCTAssertTrue(analyses.dominatorTree(of: scope) === tree)
+    XCTAssertTrue(analyses.schedule(of: scope) === schedule)
+    XCTAssertEqual([scope.entry], analyses.reversePostOrder(of: scope))
+  }
+
+  func testChangingPrimOpsReschedules() {
+    let analyses = AnalysisManager(module: self.module)
+    let scope = analyses.topLevelScopes[0]
+    let tree = analyses.dominatorTree(of: scope)
+    let schedule = analyses.schedule(of: scope)
+    XCTAssertEqual(1, schedule.blocks[0].primops.count)
+
+    // Pass a copy of the value instead, as a pass that rewrites primops
+    // would, without touching the control flow.
+    let copy = self.builder.createCopyValue(self.apply.operands[1].value)
+    self.apply.operands[1].value = copy
+    analyses.invalidate(scope, preserving: .controlFlow)
+
+    XCTAssertTrue(analyses.dominatorTree(of: scope) === tree)
+    let rescheduled = analyses.schedule(of: scope)
+    XCTAssertFalse(rescheduled === schedule)
+    XCTAssertEqual(1, rescheduled.blocks.count)
+    let primops = rescheduled.blocks[0].primops
+    XCTAssertEqual(2, primops.count)
+    XCTAssertTrue(primops.first === copy)
+    XCTAssertTrue(primops.last === self.apply)
+  }
+
+  func testInvalidatingEverything() {
+    let analyses = AnalysisManager(module: self.module)
+    let scope = analyses.topLevelScopes[0]
+    let tree = analyses.dominatorTree(of: scope)
+    let schedule = analyses.schedule(of: scope)
+
+    // Preserving the scopes keeps them, and whatever else was preserved.
+    analyses.invalidateAll(preserving: [.scopes, .schedules])
+    XCTAssertTrue(analyses.topLevelScopes[0] === scope)
+    XCTAssertTrue(analyses.schedule(of: scope) === schedule)
+    XCTAssertFalse(analyses.dominatorTree(of: scope) === tree)
+
+    // Otherwise the scopes are discovered again.
+    analyses.invalidateAll()
+    let rediscovered = analyses.topLevelScopes
+    XCTAssertEqual(1, rediscovered.count)
+    XCTAssertFalse(rediscovered[0] === scope)
+    XCTAssertFalse(analyses.schedule(of: rediscovered[0]) === schedule)
+  }
+
+  #if !(os(macOS) || os(iOS) || os(watchOS) || os(tvOS))
+  static var allTests = testCase([
+    ("testAnalysesAreCached", testAnalysesAreCached),
+    ("testChangingPrimOpsReschedules", testChangingPrimOpsReschedules),
+    ("testInvalidatingEverything", testInvalidatingEverything),
+  ])
+  #endif
+}
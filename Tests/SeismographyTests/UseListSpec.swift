@@ -0,0 +1,94 @@
+/// UseListSpec.swift
+///
+/// Copyright 2019, The Silt Language Project.
+///
+/// This project is released under the MIT license, a copy of which is
+/// available in the repository.
+
+import Moho
+import Seismography
+import XCTest
+
+class UseListSpec: XCTestCase {
+  private let continuation = Continuation(name: QualifiedName())
+
+  private func makeParameters(_ count: Int) -> [Parameter] {
+    return (0..<count).map { _ in
+      self.continuation.appendParameter(type: TypeType.shared)
+    }
+  }
+
+  func testDroppingAUseUnlinksIt() {
+    let value = self.makeParameters(1)[0]
+    let first = CopyValueOp(value)
+    let middle = DestroyValueOp(value)
+    let last = CopyValueOp(value)
+    withExtendedLifetime([first, middle, last] as [PrimOp]) {
+      XCTAssertEqual(3, Array(value.users).count)
+
+      middle.value.drop()
+      let users = Array(value.users)
+      XCTAssertEqual(2, users.count)
+      XCTAssertTrue(users[0] === last.value)
+      XCTAssertTrue(users[1] === first.value)
+
+      last.value.drop()
+      XCTAssertTrue(Array(value.users).first === first.value)
+      first.value.drop()
+      XCTAssertFalse(value.hasUsers)
+
+      // Dropping a use twice leaves the chain alone.
+      first.value.drop()
+      XCTAssertFalse(value.hasUsers)
+    }
+  }
+
+  func testRetargetingAUseMovesIt() {
+    let params = self.makeParameters(2)
+    let op = DestroyValueOp(params[0])
+    let other = CopyValueOp(params[0])
+    withExtendedLifetime([op, other] as [PrimOp]) {
+      op.value.value = params[1]
+      XCTAssertTrue(Array(params[0].users)[0] === other.value)
+      XCTAssertEqual(1, Array(params[1].users).count)
+      XCTAssertTrue(Array(params[1].users)[0] === op.value)
+    }
+  }
+
+  func testReplaceAllUsesWith() {
+    let params = self.makeParameters(2)
+    let ops = [CopyValueOp(params[0]), CopyValueOp(params[0]),
+               CopyValueOp(params[0])]
+    withExtendedLifetime(ops) {
+      params[0].replaceAllUsesWith(params[1])
+      XCTAssertFalse(params[0].hasUsers)
+      XCTAssertEqual(3, Array(params[1].users).count)
+      for op in ops {
+        XCTAssertTrue(op.value.value === params[1])
+      }
+    }
+  }
+
+  func testDestroyingAUserUnlinksItsUses() {
+    let value = self.makeParameters(1)[0]
+    let kept = CopyValueOp(value)
+    withExtendedLifetime(kept) {
+      do {
+        let temporary = DestroyValueOp(value)
+        XCTAssertEqual(2, Array(value.users).count)
+        _ = temporary
+      }
+      XCTAssertEqual(1, Array(value.users).count)
+      XCTAssertTrue(Array(value.users)[0] === kept.value)
+    }
+  }
+
+  #if !(os(macOS) || os(iOS) || os(watchOS) || os(tvOS))
+  static var allTests = testCase([
+    ("testDroppingAUseUnlinksIt", testDroppingAUseUnlinksIt),
+    ("testRetargetingAUseMovesIt", testRetargetingAUseMovesIt),
+    ("testReplaceAllUsesWith", testReplaceAllUsesWith),
+    ("testDestroyingAUserUnlinksItsUses", testDestroyingAUserUnlinksItsUses),
+  ])
+  #endif
+}